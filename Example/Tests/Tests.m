@@ -8,6 +8,163 @@
 
 @import XCTest;
 
+#import <FlexLayout-OC/FlexLayout-OC.h>
+#import <GMYogaKit/UIView+Yoga.h>
+#import <GMYogaKit/YGLayout+Private.h>
+
+/**
+ Returns the frames of a view hierarchy, depth-first.
+ */
+static NSArray<NSValue *> *GMTestsFrames(UIView *view)
+{
+    NSMutableArray<NSValue *> *frames = [NSMutableArray arrayWithObject:[NSValue valueWithCGRect:view.frame]];
+    for (UIView *subview in view.subviews) {
+        [frames addObjectsFromArray:GMTestsFrames(subview)];
+    }
+    return frames;
+}
+
+/**
+ A screen made of a header, then a padded section holding a card that has margins and two rows.
+ */
+static UIView *GMTestsMakeScreen(void)
+{
+    UIView *root = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 667)];
+    root.flex.addItem().height(44);
+    GMFlex *card = root.flex.addItem().padding(20).addItem().margin(8).padding(5);
+    card.addItem().height(30);
+    card.addItem().height(50.5);
+    return root;
+}
+
+/**
+ A grid of cards, each one having margins and holding an image and a caption. Unless homogeneous, the cards have an
+ extra style property that doesn't change their layout but makes the grid ineligible to its closed-form layout.
+ */
+static UIView *GMTestsMakeGrid(BOOL isHomogeneous)
+{
+    UIView *root = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 0)];
+    root.flex.direction(GMFlexDirectionRow).wrap(GMFlexWrap).padding(10);
+    for (NSUInteger index = 0; index < 9; index++) {
+        GMFlex *card = root.flex.addItem().width(110).height(140).margin(5).padding(3);
+        if (!isHomogeneous) {
+            card.maxWidth(1000);
+        }
+        card.addItem().grow(1).margin(2.5);
+        card.addItem().height(20.5);
+    }
+    return root;
+}
+
+static UIImage *GMTestsMakeImage(CGSize size)
+{
+    UIGraphicsBeginImageContextWithOptions(size, YES, 1);
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return image;
+}
+
+/**
+ A row of three items of different widths, having margins and separated by a column gap.
+ */
+static UIView *GMTestsMakeRow(GMFlexLayoutDirection direction)
+{
+    UIView *root = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 100)];
+    root.flex.direction(GMFlexDirectionRow).layoutDirection(direction).padding(10).columnGap(8);
+    for (NSUInteger index = 0; index < 3; index++) {
+        root.flex.addItem().width(50 + index * 10).height(40).margin(5);
+    }
+    return root;
+}
+
+/// Tag of the spacer items of GMTestsMakeSpacedRow.
+static const NSInteger GMTestsSpacerTag = 1;
+
+/**
+ A row of three items like GMTestsMakeRow, the middle one growing, separated by a column gap or by spacer items as
+ wide as the gap.
+ */
+static UIView *GMTestsMakeSpacedRow(CGFloat gap, BOOL usesSpacers, GMFlexLayoutDirection direction)
+{
+    UIView *root = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 100)];
+    root.flex.direction(GMFlexDirectionRow).layoutDirection(direction).padding(10).columnGap(usesSpacers ? 0 : gap);
+    for (NSUInteger index = 0; index < 3; index++) {
+        if (usesSpacers && index > 0) {
+            root.flex.addItem().width(gap).view.tag = GMTestsSpacerTag;
+        }
+        root.flex.addItem().width(50 + index * 10).height(40).margin(5).grow(index == 1 ? 1 : 0);
+    }
+    return root;
+}
+
+/**
+ Returns the frames of a view hierarchy like GMTestsFrames, without the spacer items.
+ */
+static NSArray<NSValue *> *GMTestsItemFrames(UIView *view)
+{
+    NSMutableArray<NSValue *> *frames = [NSMutableArray arrayWithObject:[NSValue valueWithCGRect:view.frame]];
+    for (UIView *subview in view.subviews) {
+        if (subview.tag != GMTestsSpacerTag) {
+            [frames addObjectsFromArray:GMTestsItemFrames(subview)];
+        }
+    }
+    return frames;
+}
+
+/**
+ Appends feed items to a column: rows of a thumbnail and a text block, of heights varying with their index.
+ */
+static void GMTestsAppendFeedItems(UIView *feed, NSRange range)
+{
+    for (NSUInteger index = range.location; index < NSMaxRange(range); index++) {
+        GMFlex *item = feed.flex.addItem().direction(GMFlexDirectionRow).padding(8).marginBottom(1);
+        item.addItem().sideLength(40);
+        item.addItem().grow(1).marginLeft(8).height(20 + (index % 4) * 10.5);
+    }
+}
+
+static UIView *GMTestsMakeFeed(NSUInteger itemCount)
+{
+    UIView *feed = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 0)];
+    feed.flex.padding(10);
+    GMTestsAppendFeedItems(feed, NSMakeRange(0, itemCount));
+    return feed;
+}
+
+/**
+ A detached cell of 30 items: a header made of an avatar, three lines of text and a badge, a body of four rows of
+ three items, and a footer of four buttons.
+ */
+static GMFlex *GMTestsMakeCell(CGFloat padding)
+{
+    GMFlexMeasure measureText = ^CGSize(CGSize constrainedSize) {
+        return CGSizeMake(MIN(constrainedSize.width, 120), 17);
+    };
+    GMFlex *cell = [GMFlex detachedFlex].padding(padding);
+    
+    GMFlex *header = cell.addItem().direction(GMFlexDirectionRow).alignItems(GMFlexAlignItemsCenter);
+    header.addItem().sideLength(40);
+    GMFlex *texts = header.addItem().grow(1).shrink(1).marginLeft(8);
+    for (NSUInteger index = 0; index < 3; index++) {
+        texts.addItem().measure(measureText);
+    }
+    header.addItem().sideLength(24);
+    
+    GMFlex *body = cell.addItem().marginTop(8);
+    for (NSUInteger index = 0; index < 4; index++) {
+        GMFlex *row = body.addItem().direction(GMFlexDirectionRow).marginTop(4);
+        row.addItem().sideLength(16);
+        row.addItem().grow(1).marginLeft(4).measure(measureText);
+        row.addItem().width(40).height(16);
+    }
+    
+    GMFlex *footer = cell.addItem().direction(GMFlexDirectionRow).justifyContent(GMFlexJustifyContentSpaceBetween).marginTop(8);
+    for (NSUInteger index = 0; index < 4; index++) {
+        footer.addItem().size(CGSizeMake(60, 30));
+    }
+    return cell;
+}
+
 @interface Tests : XCTestCase
 
 @end
@@ -26,9 +183,376 @@
     [super tearDown];
 }
 
-- (void)testExample
+- (void)testLayoutCacheRestoresFramesAtTheSameSize
+{
+    UIView *root = GMTestsMakeScreen();
+    root.flex.layoutCacheCapacity = 2;
+    [root.flex layout];
+    NSArray<NSValue *> *frames = GMTestsFrames(root);
+    
+    // Modified through YogaKit, the cache isn't dropped: the next layout restores it instead of calculating the tree.
+    root.subviews[0].yoga.height = YGPointValue(60);
+    [root.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsFrames(root), frames);
+}
+
+- (void)testLayoutCacheMissesAtAnotherSize
+{
+    UIView *root = GMTestsMakeScreen();
+    root.flex.layoutCacheCapacity = 2;
+    [root.flex layout];
+    root.subviews[0].yoga.height = YGPointValue(60);
+    root.frame = CGRectMake(0, 0, 667, 375);
+    [root.flex layout];
+    
+    UIView *expected = GMTestsMakeScreen();
+    expected.frame = CGRectMake(0, 0, 667, 375);
+    expected.subviews[0].flex.height(60);
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsFrames(root), GMTestsFrames(expected));
+}
+
+- (void)testLayoutCacheIsDroppedWhenADescendantChanges
+{
+    UIView *root = GMTestsMakeScreen();
+    root.flex.layoutCacheCapacity = 2;
+    [root.flex layout];
+    root.frame = CGRectMake(0, 0, 667, 375);
+    [root.flex layout];
+    
+    // Both cached layouts include the card.
+    root.frame = CGRectMake(0, 0, 375, 667);
+    root.subviews[1].subviews[0].flex.marginTop(30);
+    [root.flex layout];
+    
+    UIView *expected = GMTestsMakeScreen();
+    expected.subviews[1].subviews[0].flex.marginTop(30);
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsFrames(root), GMTestsFrames(expected));
+}
+
+- (void)testReleasingLayoutMemoryDropsTheCacheAndUpdatesTheCounters
+{
+    const GMFlexLayoutMemoryStatistics initial = [GMFlex layoutMemoryStatistics];
+    UIView *root = GMTestsMakeScreen();
+    root.flex.layoutCacheCapacity = 2;
+    [root.flex layout];
+    root.frame = CGRectMake(0, 0, 667, 375);
+    [root.flex layout];
+    
+    const GMFlexLayoutMemoryStatistics cached = [GMFlex layoutMemoryStatistics];
+    XCTAssertEqual(cached.cachedLayoutCount, initial.cachedLayoutCount + 2);
+    // Two layouts of 5 views each, at least their frames.
+    XCTAssertGreaterThanOrEqual(cached.cachedLayoutBytes, initial.cachedLayoutBytes + 2 * 5 * sizeof(CGRect));
+    
+    const NSUInteger releasedBytes = [root.flex releaseLayoutMemory];
+    const GMFlexLayoutMemoryStatistics released = [GMFlex layoutMemoryStatistics];
+    XCTAssertEqual(released.cachedLayoutCount, initial.cachedLayoutCount);
+    XCTAssertEqual(released.cachedLayoutBytes, initial.cachedLayoutBytes);
+    XCTAssertEqual(releasedBytes, cached.cachedLayoutBytes - initial.cachedLayoutBytes);
+    XCTAssertEqual(released.releasedBytes, initial.releasedBytes + releasedBytes);
+    
+    // Calculated again, the layout is unchanged.
+    NSArray<NSValue *> *frames = GMTestsFrames(root);
+    [root.flex layout];
+    XCTAssertEqualObjects(GMTestsFrames(root), frames);
+}
+
+- (void)testReleasingTheTreeUnlinksItsNodesAndKeepsItUsable
+{
+    UIView *root = GMTestsMakeScreen();
+    [root.flex layout];
+    NSArray<NSValue *> *frames = GMTestsFrames(root);
+    
+    [root.flex releaseTree];
+    XCTAssertEqual(YGNodeGetChildCount(root.yoga.node), 0u);
+    XCTAssertEqual(YGNodeGetChildCount(root.subviews[1].yoga.node), 0u);
+    
+    // The next layout attaches the nodes again.
+    [root.flex layout];
+    XCTAssertEqual(YGNodeGetChildCount(root.yoga.node), 2u);
+    XCTAssertEqualObjects(GMTestsFrames(root), frames);
+}
+
+- (void)testMirroredLayoutMatchesAnRTLLayout
+{
+    UIView *row = GMTestsMakeRow(GMFlexLayoutDirectionLTR);
+    row.flex.layoutCacheCapacity = 2;
+    [row.flex layout];
+    const NSUInteger cachedLayoutCount = [GMFlex layoutMemoryStatistics].cachedLayoutCount;
+    row.flex.layoutDirection(GMFlexLayoutDirectionRTL);
+    // Mirrored rather than dropped, then restored by the layout.
+    XCTAssertEqual([GMFlex layoutMemoryStatistics].cachedLayoutCount, cachedLayoutCount);
+    [row.flex layout];
+    
+    UIView *expected = GMTestsMakeRow(GMFlexLayoutDirectionRTL);
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsFrames(row), GMTestsFrames(expected));
+}
+
+- (void)testGapsLayOutLikeSpacerItems
+{
+    UIView *root = GMTestsMakeSpacedRow(8, NO, GMFlexLayoutDirectionLTR);
+    [root.flex layout];
+    
+    UIView *expected = GMTestsMakeSpacedRow(8, YES, GMFlexLayoutDirectionLTR);
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsItemFrames(root), GMTestsItemFrames(expected));
+}
+
+- (void)testGapsLayOutLikeSpacerItemsInRTL
+{
+    UIView *root = GMTestsMakeSpacedRow(8, NO, GMFlexLayoutDirectionRTL);
+    [root.flex layout];
+    
+    UIView *expected = GMTestsMakeSpacedRow(8, YES, GMFlexLayoutDirectionRTL);
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsItemFrames(root), GMTestsItemFrames(expected));
+}
+
+- (void)testChangingTheMarginHoldingAGap
+{
+    UIView *root = GMTestsMakeSpacedRow(8, NO, GMFlexLayoutDirectionLTR);
+    [root.flex layout];
+    // The gap is added to the new margin instead of being replaced by it.
+    root.subviews[1].flex.marginLeft(20);
+    [root.flex layout];
+    
+    UIView *expected = GMTestsMakeSpacedRow(8, YES, GMFlexLayoutDirectionLTR);
+    expected.subviews[2].flex.marginLeft(20);
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsItemFrames(root), GMTestsItemFrames(expected));
+}
+
+- (void)testChangingTheGap
+{
+    UIView *root = GMTestsMakeSpacedRow(8, NO, GMFlexLayoutDirectionLTR);
+    [root.flex layout];
+    root.flex.columnGap(12);
+    [root.flex layout];
+    
+    UIView *expected = GMTestsMakeSpacedRow(12, YES, GMFlexLayoutDirectionLTR);
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsItemFrames(root), GMTestsItemFrames(expected));
+}
+
+- (void)testRemovingTheFirstItemOfAContainerHavingGaps
+{
+    UIView *root = GMTestsMakeSpacedRow(8, NO, GMFlexLayoutDirectionLTR);
+    [root.flex layout];
+    // The new first item loses its gap margin.
+    [root.subviews[0] removeFromSuperview];
+    [root.flex layout];
+    
+    UIView *expected = GMTestsMakeSpacedRow(8, YES, GMFlexLayoutDirectionLTR);
+    [expected.subviews[0] removeFromSuperview];
+    [expected.subviews[0] removeFromSuperview];
+    [expected.flex layout];
+    
+    XCTAssertEqualObjects(GMTestsItemFrames(root), GMTestsItemFrames(expected));
+}
+
+- (void)testAppendedItemsLayoutMatchesAWholeLayout
+{
+    UIView *feed = GMTestsMakeFeed(10);
+    [feed.flex layoutAppendedItems];
+    GMTestsAppendFeedItems(feed, NSMakeRange(10, 10));
+    [feed.flex layoutAppendedItems];
+    GMTestsAppendFeedItems(feed, NSMakeRange(20, 5));
+    [feed.flex layoutAppendedItems];
+    
+    UIView *expected = GMTestsMakeFeed(25);
+    [expected.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    XCTAssertEqualObjects(GMTestsFrames(feed), GMTestsFrames(expected));
+}
+
+- (void)testAppendedItemsLayoutAfterAnEarlierItemChanged
+{
+    UIView *feed = GMTestsMakeFeed(10);
+    [feed.flex layoutAppendedItems];
+    // Moves every later item: the baseline is dropped and the whole column is laid out.
+    feed.subviews[3].flex.paddingVertical(20);
+    GMTestsAppendFeedItems(feed, NSMakeRange(10, 10));
+    [feed.flex layoutAppendedItems];
+    
+    UIView *expected = GMTestsMakeFeed(20);
+    expected.subviews[3].flex.paddingVertical(20);
+    [expected.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    XCTAssertEqualObjects(GMTestsFrames(feed), GMTestsFrames(expected));
+}
+
+- (void)testInvalidatingTextItems
+{
+    UIView *root = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 667)];
+    root.flex.alignItems(GMFlexAlignItemsStart);
+    UILabel *label = [UILabel new];
+    label.text = @"Dynamic Type";
+    label.font = [UIFont systemFontOfSize:12];
+    root.flex.addItemView(label);
+    GMFlex *container = root.flex.addItem().invalidationTags(GMFlexInvalidationTagText);
+    container.addItem().size(CGSizeMake(40, 10));
+    UIView *box = root.flex.addItem().size(CGSizeMake(40, 40)).view;
+    [root.flex layout];
+    const CGFloat labelHeight = label.frame.size.height;
+    
+    // The content size category changed the font, without marking the label dirty.
+    label.font = [UIFont systemFontOfSize:30];
+    [GMFlex invalidateItemsWithTags:GMFlexInvalidationTagText];
+    XCTAssertTrue(label.yoga.isDirty);
+    XCTAssertTrue(container.view.yoga.isDirty);
+    XCTAssertFalse(box.yoga.isDirty);
+    XCTAssertFalse(container.view.subviews[0].yoga.isDirty);
+    
+    [root.flex layout];
+    XCTAssertGreaterThan(label.frame.size.height, labelHeight);
+    XCTAssertEqual(box.frame.origin.y, CGRectGetMaxY(container.view.frame));
+}
+
+- (void)testInvalidatingImageItems
+{
+    UIView *root = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 667)];
+    root.flex.alignItems(GMFlexAlignItemsStart);
+    UIImageView *imageView = [[UIImageView alloc] initWithImage:GMTestsMakeImage(CGSizeMake(20, 20))];
+    root.flex.addItemView(imageView);
+    UILabel *label = [UILabel new];
+    label.text = @"Caption";
+    root.flex.addItemView(label);
+    [root.flex layout];
+    
+    imageView.image = GMTestsMakeImage(CGSizeMake(60, 30));
+    [GMFlex invalidateItemsWithTags:GMFlexInvalidationTagImage];
+    XCTAssertTrue(imageView.yoga.isDirty);
+    XCTAssertFalse(label.yoga.isDirty);
+    
+    [root.flex layout];
+    XCTAssertTrue(CGSizeEqualToSize(imageView.frame.size, CGSizeMake(60, 30)));
+    XCTAssertEqual(label.frame.origin.y, 30);
+}
+
+- (void)testInvalidatingPercentDependentItems
+{
+    UIView *root = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 667)];
+    GMFlex *column = root.flex.addItem().heightWithPercent(50);
+    column.addItem().widthWithPercent(50).height(20);
+    UIView *fixed = column.addItem().width(100).height(20).view;
+    UIView *footer = root.flex.addItem().height(44).view;
+    [root.flex layout];
+    
+    [GMFlex invalidateItemsWithTags:GMFlexInvalidationTagPercentDependent];
+    XCTAssertTrue(column.view.yoga.isDirty);
+    XCTAssertTrue(column.view.subviews[0].yoga.isDirty);
+    XCTAssertFalse(fixed.yoga.isDirty);
+    XCTAssertFalse(footer.yoga.isDirty);
+    
+    root.frame = CGRectMake(0, 0, 660, 380);
+    [root.flex layout];
+    XCTAssertEqual(column.view.frame.size.height, 190);
+    XCTAssertEqual(column.view.subviews[0].frame.size.width, 330);
+}
+
+- (void)testBudgetedLayoutPositionsSubtreesBelowCleanContainers
+{
+    UIView *expected = GMTestsMakeScreen();
+    [expected.flex layout];
+    expected.subviews[0].flex.height(60);
+    [expected.flex layout];
+    
+    // Only the header is dirty: the section and the card, both presolved, are cached by Yoga.
+    UIView *budgeted = GMTestsMakeScreen();
+    [budgeted.flex layout];
+    budgeted.subviews[0].flex.height(60);
+    while (![budgeted.flex layoutWithMode:GMFlexLayoutModeFitContainer budget:1 progressive:NO]) {
+    }
+    
+    XCTAssertEqualObjects(GMTestsFrames(budgeted), GMTestsFrames(expected));
+}
+
+- (void)testHomogeneousGridLayoutMatchesYoga
+{
+    UIView *expected = GMTestsMakeGrid(NO);
+    [expected.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    UIView *grid = GMTestsMakeGrid(YES);
+    [grid.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    XCTAssertEqualObjects(GMTestsFrames(grid), GMTestsFrames(expected));
+}
+
+- (void)testApplyingAnotherPrototypeDropsAttachedFrames
+{
+    GMFlex *prototype = GMTestsMakeCell(12);
+    [prototype layoutWithSize:CGSizeMake(375, 0) mode:GMFlexLayoutModeAdjustHeight];
+    UIView *view = [UIView new];
+    [prototype attachToView:view];
+    
+    // The frames cached by attachToView: are for the first prototype.
+    [GMTestsMakeCell(20) applyToView:view];
+    [view.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    XCTAssertTrue(CGPointEqualToPoint(view.subviews[0].frame.origin, CGPointMake(20, 20)));
+}
+
+- (void)testAttachingARestyledTreeDoesNotApplyItsLayout
+{
+    GMFlex *cell = GMTestsMakeCell(12);
+    [cell layoutWithSize:CGSizeMake(375, 0) mode:GMFlexLayoutModeAdjustHeight];
+    cell.padding(20);
+    UIView *view = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 0)];
+    [cell attachToView:view];
+    [view.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    UIView *expected = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 0)];
+    [GMTestsMakeCell(20) applyToView:expected];
+    [expected.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    XCTAssertEqualObjects(GMTestsFrames(view), GMTestsFrames(expected));
+}
+
+- (void)testAttachingATreeGrownAfterItsLayoutDoesNotApplyItsLayout
+{
+    GMFlex *cell = GMTestsMakeCell(12);
+    [cell layoutWithSize:CGSizeMake(375, 0) mode:GMFlexLayoutModeAdjustHeight];
+    cell.addItem().height(30);
+    UIView *view = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 0)];
+    [cell attachToView:view];
+    [view.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    GMFlex *expectedCell = GMTestsMakeCell(12);
+    expectedCell.addItem().height(30);
+    UIView *expected = [[UIView alloc] initWithFrame:CGRectMake(0, 0, 375, 0)];
+    [expectedCell applyToView:expected];
+    [expected.flex layoutWithMode:GMFlexLayoutModeAdjustHeight];
+    
+    XCTAssertEqualObjects(GMTestsFrames(view), GMTestsFrames(expected));
+    XCTAssertEqual(view.subviews.lastObject.frame.size.height, 30);
+}
+
+- (void)testPerformanceBuildingCells
+{
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < 100; index++) {
+            GMTestsMakeCell(12);
+        }
+    }];
+}
+
+- (void)testPerformanceCloningCells
 {
-    XCTFail(@"No implementation for \"%s\"", __PRETTY_FUNCTION__);
+    GMFlex *prototype = GMTestsMakeCell(12);
+    [self measureBlock:^{
+        for (NSUInteger index = 0; index < 100; index++) {
+            [prototype clone];
+        }
+    }];
 }
 
 @end
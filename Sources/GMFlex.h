@@ -12,6 +12,19 @@
 
 @class GMFlex;
 typedef void(^GMFlexDefine)(GMFlex *flex);
+typedef CGSize(^GMFlexMeasure)(CGSize constrainedSize);
+
+/**
+ Memory counters of the layouts cached by flex containers, see `+[GMFlex layoutMemoryStatistics]`.
+ */
+typedef struct {
+    /// Number of layouts currently cached.
+    NSUInteger cachedLayoutCount;
+    /// Bytes they hold: their frames, their view references and their entries, allocator overhead excluded.
+    NSUInteger cachedLayoutBytes;
+    /// Bytes released by `releaseLayoutMemory` since launch.
+    NSUInteger releasedBytes;
+} GMFlexLayoutMemoryStatistics;
 
 /**
  FlexLayout interface.
@@ -25,7 +38,8 @@ typedef void(^GMFlexDefine)(GMFlex *flex);
 
 @property (nonatomic, weak) UIView *view; // Flex items's UIView.
 /**
- Item natural size, considering only properties of the view itself. Independent of the item frame.
+ Item natural size, considering only properties of the view itself. Independent of the item frame. Detached items
+ are measured with their `measure` blocks.
  */
 @property (nonatomic, readonly) CGSize intrinsicSize;
 
@@ -71,6 +85,13 @@ GMFLEX_PROPERTY GMFlex * (^addItemView)(UIView *);
 /**
  The method layout the flex container's children
  
+ When the receiver itself is a homogeneous wrapping grid, its items are framed in closed form instead of being
+ calculated: an LTR row or column, justified at its start, with point paddings, whose items all have the same point
+ width and height, point margins and no other property but `alignSelf`. Grids nested deeper in the tree, for example
+ in a cell or a scroll view content, are calculated by Yoga with the rest of the tree: YogaKit attaches every item to
+ the Yoga tree on each layout, so their items can't be left out of it. Call `layout` on such a grid's own view to
+ frame it in closed form.
+ 
  - Parameter mode: specify the layout mod (LayoutMode).
  */
 - (void)layoutWithMode:(GMFlexLayoutMode)mode;
@@ -79,6 +100,27 @@ GMFLEX_PROPERTY GMFlex * (^addItemView)(UIView *);
  */
 - (void)layout;
 
+/**
+ Lays out the flex container's children like `layoutWithMode:`, spread over several calls so that a large layout
+ doesn't hold a frame. Call it again, typically on the next frames, until it returns YES.
+ 
+ Each call calculates, within the budget, the next subtrees whose constraints are known before their container is
+ calculated: non-leaf items having a width, and the stretched items of columns whose inner width is known. Yoga
+ caches their layout, then the last call calculates the whole tree, laying out again the containers of those subtrees
+ to position them, and applies the frames. Any subtree calculated takes at least one call, the budget is checked
+ between subtrees.
+ 
+ A new pass starts when the mode or the container size changes. Calling `layoutWithMode:` ends the current pass.
+ Modifications made during a pass are taken into account by its last call.
+ 
+ - Parameter mode: specify the layout mode (LayoutMode).
+ - Parameter budget: time in seconds the call may take, e.g. what is left of the current frame.
+ - Parameter progressive: YES to apply the frames inside each subtree as soon as it is calculated, the subtree
+   itself being framed by the last call. NO to apply all frames at once on the last call.
+ - Returns: YES if the layout is complete and applied, NO if it must be called again.
+ */
+- (BOOL)layoutWithMode:(GMFlexLayoutMode)mode budget:(NSTimeInterval)budget progressive:(BOOL)progressive;
+
 /**
  This method controls dynamically if a flexbox's UIView is included or not in the flexbox layouting. When a
  flexbox's UIView is excluded, FlexLayout won't layout the view and its children views.
@@ -107,6 +149,186 @@ GMFLEX_PROPERTY GMFlex * (^markDirty)(void);
  */
 - (CGSize)sizeThatFits:(CGSize)size;
 
+/**
+ The number of layouts a root flex container remembers. When `layout` or `layoutWithMode:` is called again with a
+ container size seen recently (rotation, iPad split-view resizing), the frames of the whole tree are restored from
+ the cache instead of being calculated again.
+ 
+ Any flex property change, `markDirty()` or item addition in the tree drops the cached layouts. If you modify the
+ view hierarchy or a view content directly, call `markDirty()` as you would do without the cache.
+ 
+ Default value is 0 (no cache).
+ */
+@property (nonatomic, assign) NSUInteger layoutCacheCapacity;
+
+/**
+ Releases the memory FlexLayout holds for the tree of the receiver and can rebuild: the cached layouts of its items,
+ their append baselines and any pending budgeted layout pass. Call it when the tree goes offscreen, for example the
+ page or tab holding it. The next layout calculates the tree again, which fills the cache again.
+ 
+ The Yoga nodes and their styles are owned by YogaKit, one per view, and stay allocated as long as their views: they
+ can't be compacted or released while the view hierarchy is kept.
+ 
+ - Returns: number of bytes released, as counted by `layoutMemoryStatistics`.
+ */
+- (NSUInteger)releaseLayoutMemory;
+
+/**
+ Returns the memory counters of the cached layouts of all flex containers.
+ */
++ (GMFlexLayoutMemoryStatistics)layoutMemoryStatistics;
+
+/**
+ Tears down the flex tree of the receiver in one pass, usually the root view of a screen going away: its layout
+ memory is released like `releaseLayoutMemory` does, and every container of the Yoga tree drops all its children at
+ once.
+ 
+ Otherwise each Yoga node freed with its view while still attached removes itself from its parent's children list, a
+ search and a shift per node, which makes the teardown of wide containers quadratic. Once unlinked, each node is freed
+ in constant time. `Tools/FlexTeardownBenchmark` compares both paths.
+ 
+ The flex interfaces, their YGLayout and the Yoga nodes stay one allocation each: Yoga 1.9 takes no allocator and
+ YogaKit allocates its own objects, so they can't come from a shared region. The tree stays usable, its next layout
+ attaches the Yoga nodes again.
+ */
+- (void)releaseTree;
+
+/**
+ Lays out the items appended to a root column since its previous `layoutAppendedItems`, like
+ `layoutWithMode:GMFlexLayoutModeAdjustHeight` would, for infinite feeds. Only the new items are calculated and
+ framed, the frames of the earlier items are left untouched, then the container height is updated.
+ 
+ The first call, and any call where the incremental path doesn't apply, lays out the whole column. It applies when:
+ - The container is a column, without wrapping, justified at its start, without height, min/max height or aspect
+   ratio, and none of its earlier items is absolutely positioned.
+ - Its width didn't change and its earlier items were neither removed nor reordered.
+ - Neither the container nor its earlier items were modified since. Modifications going through the flex interface,
+   including `markDirty()`, are detected. If you modify an earlier item view hierarchy or content directly, call its
+   `markDirty()`.
+ 
+ Incremental layouts don't fill the layout cache.
+ */
+- (void)layoutAppendedItems;
+
+/**
+ Applies a frame table solved at compile time by `GMFlexStaticLayout.h`, without calculating the flex tree, for
+ static layouts whose frames don't depend on any content.
+ 
+ The first frame is the receiver's: its size is applied and the view origin is offset by the root margins, as
+ `layout` does. The next ones are the frames of the items of the tree, in depth-first order, which must follow the
+ static description. The flex properties of the tree aren't read, a later `layout` calculates the tree as usual.
+ 
+ - Parameter frames: frame table, see `gmflex::rects()`.
+ - Parameter count: number of frames, the receiver and all its included items.
+ */
+- (void)applyFrames:(const CGRect *)frames count:(NSUInteger)count;
+
+/**
+ Writes the flex tree of the receiver to a file, to reproduce a slow layout offline with `Tools/FlexReplay`.
+ 
+ The capture holds every flex property of the tree, the container size, the layout mode and the result of every
+ call of the measure functions of the leaves, which are measured again for the capture. The tree is calculated
+ before being captured, but frames aren't applied.
+ 
+ - Parameter mode: layout mode to capture, the container size is the view's current size.
+ - Parameter path: file to write.
+ - Returns: NO if the file couldn't be written.
+ */
+- (BOOL)captureLayoutWithMode:(GMFlexLayoutMode)mode toFile:(NSString *)path;
+
+#pragma mark - Invalidation tags
+
+/**
+ Sets the invalidation categories of the item, replacing the ones it was tagged with automatically, see
+ `GMFlexInvalidationTag`. Pass 0 to remove the item from every category.
+ 
+ - Parameter tags: categories of the item.
+ - Returns: Flex interface
+ */
+GMFLEX_PROPERTY GMFlex * (^invalidationTags)(GMFlexInvalidationTag);
+
+/**
+ Marks dirty every live item having one of the tags, e.g. all the text items when the content size category changes,
+ and calls `setNeedsLayout` on the superview of the root view of their trees, whose `layoutSubviews` usually lays out
+ the root (on the root itself if it has no superview). Tagged items are indexed, other items aren't visited, and the
+ next layout only calculates again the paths from the dirty items to their root.
+ 
+ - Parameter tags: categories to invalidate.
+ */
++ (void)invalidateItemsWithTags:(GMFlexInvalidationTag)tags;
+
+#pragma mark - Detached flex tree
+
+/**
+ Creates a flex item that isn't attached to a view. A detached tree can be built with `addItem()` and `define()`,
+ styled and laid out on any thread, then attached to the views on the main thread with `attachToView:`. This moves
+ the tree construction and its layout off the main thread, for example when preparing a complex cell.
+ 
+ Threading rules, checked by assertions:
+ - A flex item attached to a view is created, modified and laid out on the main thread only.
+ - A detached tree is modified and laid out by one thread at a time. It doesn't touch any view.
+ - `attachToView:` is called on the main thread, after which the detached tree can't be modified anymore.
+ 
+ Yoga's configuration reads the screen scale the first time a flex item is created: a view's flex, or a detached
+ item, must be created on the main thread before detached trees are built in the background. This is asserted.
+ 
+ - Returns: a new detached flex item
+ */
++ (instancetype)detachedFlex;
+
+/**
+ Layout a detached flex tree in a container of the specified size. Use `sizeThatFits:` to only get its size.
+ 
+ - Parameter size: container size, only its width is used in `.adjustHeight` mode and its height in `.adjustWidth`.
+ - Parameter mode: specify the layout mode (LayoutMode).
+ */
+- (void)layoutWithSize:(CGSize)size mode:(GMFlexLayoutMode)mode;
+
+/**
+ Set the measure block of a detached leaf item, which plays the part of the `sizeThatFits:` of its future view.
+ The block is called on the thread laying out the tree, `CGFLOAT_MAX` means unconstrained.
+ 
+ Only available on detached flex items.
+ */
+GMFLEX_PROPERTY GMFlex * (^measure)(GMFlexMeasure);
+
+/**
+ Copies the detached tree styles to the flex interfaces of `view` and its subviews, and applies the frames calculated
+ by `layoutWithSize:mode:` if any. Detached items are matched to subviews by index, missing subviews are created.
+ Frames aren't applied if the tree was modified, items added, or `sizeThatFits:` called since that layout.
+ 
+ The next `layoutWithMode:` of `view` in the same mode and size restores these frames without calculating the
+ layout again, until the tree is modified.
+ 
+ Must be called on the main thread.
+ 
+ - Parameter view: the root view of the tree
+ */
+- (void)attachToView:(UIView *)view;
+
+#pragma mark - Prototype
+
+/**
+ Uses the receiver, a detached flex tree, as a prototype: copies its styles to the flex interfaces of `view` and its
+ subviews. Detached items are matched to subviews by index, missing subviews are created. The prototype isn't
+ consumed and can be applied to any number of views, for example to every new cell instead of building its flex
+ tree with setter chains.
+ 
+ Each item style is copied at once, and items whose style already equals the prototype are left untouched, so
+ applying the prototype again to a reused cell doesn't invalidate its layout.
+ 
+ Must be called on the main thread.
+ 
+ - Parameter view: the root view of the tree
+ */
+- (void)applyToView:(UIView *)view;
+
+/**
+ Returns a copy of the receiver, a detached flex tree, with the same styles and measure blocks. The copy is a new
+ detached tree that can be modified and laid out independently, on any thread.
+ */
+- (GMFlex *)clone;
+
 #pragma mark - Direction, wrap, flow
 
 /**
@@ -126,6 +348,8 @@ GMFLEX_PROPERTY GMFlex * (^direction)(GMFlexDirection);
 /**
  The `wrap` property controls whether the flex container is single-lined or multi-lined, and the direction of the cross-axis, which determines the direction in which the new lines are stacked in.
  
+ Wrapping containers can't have gaps, see `rowGap`.
+ 
  - Parameter value: Default value is .noWrap
  */
 GMFLEX_PROPERTY GMFlex * (^wrap)(GMFlexWrapMode);
@@ -135,6 +359,12 @@ GMFLEX_PROPERTY GMFlex * (^wrap)(GMFlexWrapMode);
  user’s preferred direction (most platforms have a standard way of doing this) and setting this direction on the
  root of your layout tree.
  
+ Switching the root between LTR and RTL keeps its cached layouts mirrored, instead of calculating the tree again,
+ when every item is symmetric: items don't set their own direction, and their left and right margins, paddings,
+ borders and positions are equal, the root start and end margins too. Gaps don't break the symmetry. Only roots
+ having a `layoutCacheCapacity` above 0 have cached layouts to mirror: with the default capacity of 0, switching the
+ direction calculates the tree again.
+ 
  - Parameter value: new LayoutDirection
  - Returns:
  */
@@ -358,6 +588,27 @@ GMFLEX_PROPERTY GMFlex * (^aspectRatio)(CGFloat);
  */
 GMFLEX_PROPERTY GMFlex * (^aspectRatioOfImageView)(UIImageView *);
 
+/**
+ Set the aspect ratio of an encoded PNG, JPEG, GIF or WebP image by reading only its header, the image is not decoded.
+ This lets you layout an item before its image has been decoded. The EXIF orientation of JPEG images is taken into
+ account, like `UIImage` does, and PNGs crushed by Xcode for the app bundle are supported.
+ 
+ The aspect ratio is left unchanged if the data isn't a supported image.
+ 
+ - Parameter data: encoded image data, or at least its beginning
+ */
+GMFLEX_PROPERTY GMFlex * (^aspectRatioOfImageData)(NSData *);
+
+/**
+ Same as `aspectRatioOfImageData`, but reads only the beginning of the image file at the specified path.
+ 
+ The file is read synchronously on the calling thread: prefer `aspectRatioOfImageData` on the main thread unless the
+ file is known to be local and small. The aspect ratio is left unchanged if the file can't be read.
+ 
+ - Parameter path: image file path
+ */
+GMFLEX_PROPERTY GMFlex * (^aspectRatioOfImageFile)(NSString *);
+
 #pragma mark - Absolute positionning
 
 /**
@@ -654,6 +905,35 @@ GMFLEX_PROPERTY GMFlex * (^paddingVH)(CGFloat, CGFloat);
  */
 GMFLEX_PROPERTY GMFlex * (^paddingAll)(CGFloat, CGFloat, CGFloat, CGFloat);
 
+#pragma mark - Gap
+
+/**
+ Set the space between the rows of a container, that is between the items of a column. Replaces spacer items and
+ margins on every item, without adding any item to the tree.
+ 
+ Gaps are laid out as margins added to the items before the tree is calculated, on the side facing the previous item,
+ so that the free space seen by `flexGrow`, `flexShrink` and `justifyContent` is the same as with CSS gaps. Absolutely
+ positioned items are ignored. An item must have a point margin, or none, on that side.
+ 
+ Gaps aren't supported by wrapping containers: Yoga breaks their lines without them. Setting one on a wrapping
+ container asserts, and it is rejected in release builds. Making a container having gaps wrap asserts too, and drops
+ its gaps in release builds.
+ 
+ - Parameter value: gap, in points.
+ - Returns: flex interface
+ */
+GMFLEX_PROPERTY GMFlex * (^rowGap)(CGFloat);
+
+/**
+ Set the space between the columns of a container, that is between the items of a row. See `rowGap`.
+ */
+GMFLEX_PROPERTY GMFlex * (^columnGap)(CGFloat);
+
+/**
+ Set both `rowGap` and `columnGap` to the specified value.
+ */
+GMFLEX_PROPERTY GMFlex * (^gap)(CGFloat);
+
 #pragma mark - UIView Visual properties
 
 /**
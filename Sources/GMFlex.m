@@ -6,9 +6,283 @@
 //
 
 #import "GMFlex.h"
+#import <objc/runtime.h>
 #import <GMYogaKit/YGLayout.h>
+#import <GMYogaKit/YGLayout+Private.h>
 #import <GMYogaKit/UIView+Yoga.h>
 #import "UIView+FlexLayout.h"
+#import "GMImageHeader.h"
+#import "GMFlexCapture.h"
+#import "GMFlexGrid.h"
+#import "GMFlexStyle.h"
+
+/// Number of flex items holding cached layouts or an append baseline. Mutations skip the ancestors walk while it is 0.
+static NSUInteger GMFlexLayoutCachingItemCount = 0;
+
+/// Memory counters of the cached layouts, see +layoutMemoryStatistics.
+static GMFlexLayoutMemoryStatistics GMFlexLayoutMemory;
+
+/// Whether a flex item was created on the main thread, which initialized YogaKit's configuration with the screen scale.
+static BOOL GMFlexHasCreatedItemOnMainThread = NO;
+
+/// Flex containers attached to a view having gaps, and attached flex items holding a gap margin, weak. Layouts don't
+/// walk their tree for gaps while both are empty.
+static NSHashTable<GMFlex *> *GMFlexGapContainers;
+static NSHashTable<GMFlex *> *GMFlexGapItems;
+
+/**
+ Margin added to an item by the gap of its container, on the edge Yoga reads for the side facing the previous item.
+ */
+typedef struct {
+    YGEdge edge;
+    float amount; // 0 if none.
+    YGValue original; // Style value of the edge before the gap was added, undefined or a point value.
+} GMFlexGapMargin;
+
+/// Number of GMFlexInvalidationTag bits.
+#define GMFLEX_INVALIDATION_TAG_COUNT 3
+
+/// Weak index of the tagged flex items attached to a view, one table per GMFlexInvalidationTag bit.
+static NSHashTable<GMFlex *> *GMFlexTaggedItems[GMFLEX_INVALIDATION_TAG_COUNT];
+
+/**
+ Returns the flex interface of the view, or nil if it was never created. Uses the same key as `-[UIView flex]`.
+ */
+static inline GMFlex *GMFlexOfView(UIView *view)
+{
+    return objc_getAssociatedObject(view, @selector(flex));
+}
+
+/**
+ Collects, in depth-first order, the views of the hierarchy that Yoga positions when laying out `view`.
+ */
+static void GMFlexCollectLayoutViews(UIView *view, NSMutableArray<UIView *> *views)
+{
+    for (UIView *subview in view.subviews) {
+        if (!subview.isYogaEnabled) {
+            continue;
+        }
+        
+        YGLayout *yoga = subview.yoga;
+        if (!yoga.isEnabled || !yoga.isIncludedInLayout) {
+            continue;
+        }
+        
+        [views addObject:subview];
+        if (!yoga.isLeaf) {
+            GMFlexCollectLayoutViews(subview, views);
+        }
+    }
+}
+
+/**
+ Returns a node border as a YGValue, to be resolved like paddings and margins.
+ */
+static YGValue GMFlexStyleGetBorder(YGNodeRef node, YGEdge edge)
+{
+    const float border = YGNodeStyleGetBorder(node, edge);
+    return YGFloatIsUndefined(border) ? YGValueUndefined : (YGValue){border, YGUnitPoint};
+}
+
+/**
+ Sums the left and right values of a node edge property, resolved as Yoga does in LTR.
+ 
+ - Returns: NO if one of them isn't a point value.
+ */
+static BOOL GMFlexHorizontalEdgesLength(YGNodeRef node, YGValue (*edgeValue)(YGNodeRef, YGEdge), CGFloat *length)
+{
+    static const YGEdge edges[2][4] = {
+        {YGEdgeStart, YGEdgeLeft, YGEdgeHorizontal, YGEdgeAll},
+        {YGEdgeEnd, YGEdgeRight, YGEdgeHorizontal, YGEdgeAll},
+    };
+    CGFloat sum = 0;
+    for (int side = 0; side < 2; side++) {
+        for (int i = 0; i < 4; i++) {
+            const YGValue value = edgeValue(node, edges[side][i]);
+            if (value.unit == YGUnitUndefined) {
+                continue;
+            }
+            if (value.unit != YGUnitPoint) {
+                return NO;
+            }
+            sum += value.value;
+            break;
+        }
+    }
+    *length = sum;
+    return YES;
+}
+
+/**
+ Returns the width available to the children of a node of the specified width, or NAN if it isn't known.
+ */
+static CGFloat GMFlexInnerWidth(YGNodeRef node, CGFloat width)
+{
+    CGFloat padding, border;
+    if (isnan(width) ||
+        !GMFlexHorizontalEdgesLength(node, YGNodeStyleGetPadding, &padding) ||
+        !GMFlexHorizontalEdgesLength(node, GMFlexStyleGetBorder, &border)) {
+        return NAN;
+    }
+    return width - padding - border;
+}
+
+/**
+ Collects, in post-order, the non-leaf descendants of `view` whose constraints are known before `view` is calculated,
+ along with the owner width to calculate them with: items having a point width, and stretched items of columns.
+ 
+ - Parameter innerWidth: width available to the children of `view`, NAN if it isn't known.
+ */
+static void GMFlexCollectPresolvableSubtrees(UIView *view, CGFloat innerWidth, NSPointerArray *subtrees, NSMutableData *ownerWidths)
+{
+    YGNodeRef node = view.yoga.node;
+    const YGFlexDirection direction = YGNodeStyleGetFlexDirection(node);
+    const BOOL isColumn = direction == YGFlexDirectionColumn || direction == YGFlexDirectionColumnReverse;
+    
+    for (UIView *subview in view.subviews) {
+        if (!subview.isYogaEnabled) {
+            continue;
+        }
+        
+        YGLayout *yoga = subview.yoga;
+        if (!yoga.isEnabled || !yoga.isIncludedInLayout || yoga.isLeaf) {
+            continue;
+        }
+        
+        YGNodeRef child = yoga.node;
+        const YGValue width = YGNodeStyleGetWidth(child);
+        YGAlign align = YGNodeStyleGetAlignSelf(child);
+        if (align == YGAlignAuto) {
+            align = YGNodeStyleGetAlignItems(node);
+        }
+        
+        BOOL isPresolvable = NO;
+        CGFloat childWidth = NAN;
+        CGFloat margins;
+        if (width.unit == YGUnitPoint) {
+            isPresolvable = YES;
+            childWidth = width.value;
+        } else if (width.unit != YGUnitPercent && !isnan(innerWidth) && isColumn && align == YGAlignStretch &&
+                   YGNodeStyleGetPositionType(child) == YGPositionTypeRelative) {
+            isPresolvable = YES;
+            if (GMFlexHorizontalEdgesLength(child, YGNodeStyleGetMargin, &margins)) {
+                childWidth = innerWidth - margins;
+            }
+        }
+        
+        GMFlexCollectPresolvableSubtrees(subview, GMFlexInnerWidth(child, childWidth), subtrees, ownerWidths);
+        if (isPresolvable) {
+            [subtrees addPointer:(__bridge void *)subview];
+            [ownerWidths appendBytes:&innerWidth length:sizeof(innerWidth)];
+        }
+    }
+}
+
+/**
+ Marks a node dirty, and its ancestors, without changing its style. Yoga only lets leaves with a measure function be
+ marked dirty, but toggling a style property marks any node.
+ */
+static void GMFlexMarkContainerDirty(YGNodeRef node)
+{
+    const YGDisplay display = YGNodeStyleGetDisplay(node);
+    YGNodeStyleSetDisplay(node, display == YGDisplayFlex ? YGDisplayNone : YGDisplayFlex);
+    YGNodeStyleSetDisplay(node, display);
+}
+
+/**
+ Returns the part of the container size used as layout constraint in the specified mode.
+ */
+static inline CGSize GMFlexConstrainedSize(CGSize size, GMFlexLayoutMode mode)
+{
+    switch (mode) {
+        case GMFlexLayoutModeAdjustHeight:
+            return CGSizeMake(size.width, 0);
+        case GMFlexLayoutModeAdjustWidth:
+            return CGSizeMake(0, size.height);
+        default:
+            return size;
+    }
+}
+
+/**
+ Returns the screen scale, which YogaKit uses as point scale factor.
+ */
+static inline CGFloat GMFlexScreenScale(void)
+{
+    static CGFloat scale;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        scale = [UIScreen mainScreen].scale;
+    });
+    return scale;
+}
+
+/**
+ Rounds a value to the pixel grid the way YogaKit does when applying frames.
+ */
+static inline CGFloat GMFlexRoundPixelValue(CGFloat value)
+{
+    const CGFloat scale = GMFlexScreenScale();
+    return round(value * scale) / scale;
+}
+
+/**
+ Returns the frame of a laid out node, pixel aligned, offset by `origin`.
+ */
+static inline CGRect GMFlexFrameOfNode(YGNodeRef node, CGPoint origin)
+{
+    const CGPoint topLeft = CGPointMake(YGNodeLayoutGetLeft(node) + origin.x, YGNodeLayoutGetTop(node) + origin.y);
+    const CGPoint bottomRight = CGPointMake(topLeft.x + YGNodeLayoutGetWidth(node), topLeft.y + YGNodeLayoutGetHeight(node));
+    return CGRectMake(GMFlexRoundPixelValue(topLeft.x),
+                      GMFlexRoundPixelValue(topLeft.y),
+                      GMFlexRoundPixelValue(bottomRight.x) - GMFlexRoundPixelValue(topLeft.x),
+                      GMFlexRoundPixelValue(bottomRight.y) - GMFlexRoundPixelValue(topLeft.y));
+}
+
+/**
+ Frames of a laid out tree, restorable as long as the tree is not invalidated.
+ */
+@interface GMFlexLayoutCacheEntry : NSObject
+
+@property (nonatomic, assign) GMFlexLayoutMode mode;
+@property (nonatomic, assign) CGSize constrainedSize;
+@property (nonatomic, assign) CGPoint originOffset; // Root origin change applied by the layout.
+@property (nonatomic, assign) CGSize size; // Root size after the layout.
+@property (nonatomic, strong) NSPointerArray *views; // Weak, depth-first order.
+@property (nonatomic, strong) NSData *frames; // CGRect array, same order as `views`.
+@property (nonatomic, readonly) NSUInteger byteCount; // Counted in GMFlexLayoutMemory while the entry is alive.
+
+/**
+ Counts the memory held by the entry, once its views and frames are set.
+ */
+- (void)countBytes;
+
+@end
+
+@implementation GMFlexLayoutCacheEntry
+
+- (void)countBytes
+{
+    _byteCount = class_getInstanceSize([self class]) + _frames.length + _views.count * sizeof(void *);
+    GMFlexLayoutMemory.cachedLayoutCount++;
+    GMFlexLayoutMemory.cachedLayoutBytes += _byteCount;
+}
+
+- (void)dealloc
+{
+    if (_byteCount > 0) {
+        GMFlexLayoutMemory.cachedLayoutCount--;
+        GMFlexLayoutMemory.cachedLayoutBytes -= _byteCount;
+    }
+}
+
+@end
+
+static void GMFlexSyncDetachedNodes(GMFlex *flex);
+static void GMFlexCopyGaps(GMFlex *flex, GMFlex *source);
+static void GMFlexSyncGaps(GMFlex *container, YGDirection direction, BOOL recursive);
+static YGDirection GMFlexInheritedDirection(GMFlex *container);
+static void GMFlexCaptureGapsOfNode(YGNodeRef node, GMFlexCaptureGaps *gaps);
 
 @interface GMFlex()
 
@@ -17,104 +291,1201 @@
 @end
 
 @implementation GMFlex
+{
+    NSMutableArray<GMFlexLayoutCacheEntry *> *_layoutCache; // Most recently used first.
+    
+    // Detached flex tree
+    BOOL _isDetached;
+    BOOL _isAttached;
+    NSMutableArray<GMFlex *> *_detachedChildren;
+    GMFlexMeasure _measure;
+    BOOL _hasDetachedLayout;
+    GMFlexLayoutMode _detachedLayoutMode;
+    CGSize _detachedLayoutSize;
+    
+    // Append baseline, see layoutAppendedItems
+    BOOL _hasAppendBaseline;
+    CGFloat _appendBaselineWidth;
+    NSUInteger _appendBaselineSubviewCount;
+    NSUInteger _appendBaselineItemCount;
+    __weak UIView *_appendBaselineLastSubview;
+    BOOL _isAppendBaselined; // Set on the items of a container having an append baseline.
+    
+    // Budgeted layout pass, see layoutWithMode:budget:progressive:
+    NSPointerArray *_budgetedSubtrees; // Weak, post-order, nil if no pass is pending.
+    NSData *_budgetedOwnerWidths; // CGFloat per subtree.
+    NSUInteger _budgetedIndex;
+    GMFlexLayoutMode _budgetedMode;
+    CGSize _budgetedSize;
+    
+    GMFlexInvalidationTag _invalidationTags;
+    
+    // Gaps, see GMFlexSyncGaps
+    CGFloat _rowGap;
+    CGFloat _columnGap;
+    GMFlexGapMargin _gapMargin;
+}
 
 #pragma mark - Properties
 
-- (CGSize)intrinsicSize
+- (CGSize)intrinsicSize
+{
+    if (_isDetached) {
+        // YogaKit would measure the missing view.
+        return [self sizeThatFits:CGSizeMake(YGUndefined, YGUndefined)];
+    }
+    
+    [self applyGapMargins];
+    return _yoga.intrinsicSize;
+}
+
+/**
+ Every flex property setter reaches Yoga through this accessor, so it is also where the cached layouts of the tree
+ are dropped, the gap margins removed and the threading rules checked. Read-only paths use the `_yoga` ivar.
+ */
+- (YGLayout *)yoga
+{
+    NSAssert(_isDetached || [NSThread isMainThread], @"A flex item attached to a view must be modified on the main thread");
+    NSAssert(!_isAttached, @"Trying to modify a detached flex tree after it was attached, modify the views flex instead");
+    
+    [self invalidateCachedLayouts];
+    [self removeGapMargins];
+    return _yoga;
+}
+
+#pragma mark - Lifecycle
+
+- (instancetype)initWithView:(UIView *)view
+{
+    self = [super init];
+    if (self) {
+        self.view = view;
+        self.yoga = view.yoga;
+        GMFlexHasCreatedItemOnMainThread = YES;
+        
+        // Enable flexbox and overwrite Yoga default values.
+        _yoga.isEnabled = YES;
+        _isIncludedInLayout = YES;
+        
+        if ([view isKindOfClass:[UILabel class]] || [view isKindOfClass:[UITextField class]] || [view isKindOfClass:[UITextView class]]) {
+            [self addInvalidationTags:GMFlexInvalidationTagText];
+        } else if ([view isKindOfClass:[UIImageView class]]) {
+            [self addInvalidationTags:GMFlexInvalidationTagImage];
+        }
+    }
+    return self;
+}
+
++ (instancetype)detachedFlex
+{
+    return [[self alloc] initDetached];
+}
+
+- (instancetype)initDetached
+{
+    NSAssert(GMFlexHasCreatedItemOnMainThread || [NSThread isMainThread],
+             @"YogaKit reads the screen scale when its first node is created, use a view's flex on the main thread before building detached trees in the background");
+    
+    self = [super init];
+    if (self) {
+        _isDetached = YES;
+        _yoga = [[YGLayout alloc] initWithView:nil];
+        if ([NSThread isMainThread]) {
+            GMFlexHasCreatedItemOnMainThread = YES;
+        }
+        _yoga.isEnabled = YES;
+        _isIncludedInLayout = YES;
+        _detachedChildren = [NSMutableArray array];
+        
+        // The node context is used by the measure function of detached leaves.
+        YGNodeSetContext(_yoga.node, (__bridge void *)self);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_layoutCache.count > 0) {
+        GMFlexLayoutCachingItemCount--;
+    }
+    if (_hasAppendBaseline) {
+        GMFlexLayoutCachingItemCount--;
+    }
+}
+
+#pragma mark - Flex item addition and definition
+
+- (GMFlex * (^)(void))addItem
+{
+    return ^id(void) {
+        if (self->_isDetached) {
+            NSAssert(!self->_isAttached, @"Trying to modify a detached flex tree after it was attached");
+            GMFlex *item = [GMFlex detachedFlex];
+            [self->_detachedChildren addObject:item];
+            return item;
+        }
+        
+        UIView *view = [UIView new];
+        return self.addItemView(view);
+    };
+}
+
+- (GMFlex * (^)(UIView *))addItemView
+{
+    return ^id(UIView *view) {
+        NSAssert(!self->_isDetached, @"Views can't be added to a detached flex tree, use addItem() instead");
+        NSAssert(self.view != nil, @"Trying to modify deallocated host view");
+        NSAssert([NSThread isMainThread], @"Flex items attached to a view must be added on the main thread");
+        
+        [self.view addSubview:view];
+        [self invalidateCachedLayoutsAppendingItem:YES];
+        return view.flex;
+    };
+}
+
+- (GMFlex * (^)(GMFlexDefine))define
+{
+    return ^id(GMFlexDefine closure){
+        closure(self);
+        return self;
+    };
+}
+
+#pragma mark - Layout / intrinsicSize / sizeThatFits
+
+- (void)layout
+{
+    [self layoutWithMode:GMFlexLayoutModeFitContainer];
+}
+
+/**
+ The method layout the flex container's children
+ 
+ - Parameter mode: specify the layout mod (LayoutMode).
+ */
+- (void)layoutWithMode:(GMFlexLayoutMode)mode
+{
+    NSAssert(!_isDetached, @"A detached flex tree must be laid out with layoutWithSize:mode:");
+    NSAssert([NSThread isMainThread], @"A flex item attached to a view must be laid out on the main thread");
+    
+    [self clearAppendBaseline];
+    _budgetedSubtrees = nil;
+    _budgetedOwnerWidths = nil;
+    if (_layoutCache.count > 0 && [self restoreCachedLayoutWithMode:mode]) {
+        return;
+    }
+    
+    // Keyed by the size the cached layouts are looked up with.
+    const CGPoint origin = self.view.frame.origin;
+    const CGSize size = self.view.bounds.size;
+    
+    [self applyGapMargins];
+    if ([self layoutHomogeneousGridWithMode:mode]) {
+        // Laid out in closed form.
+    } else if (mode == GMFlexLayoutModeFitContainer) {
+        [_yoga applyLayoutPreservingOrigin:YES];
+    } else {
+        [_yoga applyLayoutPreservingOrigin:YES dimensionFlexibility:mode == GMFlexLayoutModeAdjustWidth ? YGDimensionFlexibilityFlexibleWidth : YGDimensionFlexibilityFlexibleHeight];
+    }
+    
+    if (_layoutCacheCapacity > 0) {
+        [self cacheLayoutWithMode:mode
+                  constrainedSize:GMFlexConstrainedSize(size, mode)
+                   previousOrigin:origin
+                         capacity:_layoutCacheCapacity];
+    }
+}
+
+- (void)setIsIncludedInLayout:(BOOL)isIncludedInLayout
+{
+    _isIncludedInLayout = isIncludedInLayout;
+    self.yoga.isIncludedInLayout = isIncludedInLayout;
+}
+
+- (GMFlex * (^)(BOOL))flex_isIncludedInLayout
+{
+    return ^id(BOOL included) {
+        self.isIncludedInLayout = included;
+        return self;
+    };
+}
+
+- (GMFlex * (^)(void))markDirty
+{
+    return ^id {
+        if (self->_isDetached) {
+            // YogaKit would mark the node of the missing view. Detached leaves only get their measure function when
+            // the tree is calculated, so the node is marked through its style.
+            GMFlexMarkContainerDirty(self.yoga.node);
+            return self;
+        }
+        
+        [self.yoga markDirty];
+        return self;
+    };
+}
+
+- (CGSize)sizeThatFits:(CGSize)size
+{
+    if (_isDetached) {
+        [self applyGapMargins];
+        GMFlexSyncDetachedNodes(self);
+        YGNodeCalculateLayout(_yoga.node, size.width, size.height, YGNodeStyleGetDirection(_yoga.node));
+        // The layout of the tree is replaced by this one.
+        _hasDetachedLayout = NO;
+        return CGSizeMake(YGNodeLayoutGetWidth(_yoga.node), YGNodeLayoutGetHeight(_yoga.node));
+    }
+    
+    [self applyGapMargins];
+    return [_yoga calculateLayoutWithSize:size];
+}
+
+- (BOOL)captureLayoutWithMode:(GMFlexLayoutMode)mode toFile:(NSString *)path
+{
+    CGSize size = self.view.bounds.size;
+    CGSize constrainedSize = CGSizeMake(mode == GMFlexLayoutModeAdjustWidth ? YGUndefined : size.width,
+                                        mode == GMFlexLayoutModeAdjustHeight ? YGUndefined : size.height);
+    
+    // Attaches the Yoga nodes to the view hierarchy, with the gap margins, then calculates the tree again without
+    // reattaching it, which would replace the recording measure functions, to record every measurement of a solve.
+    [self applyGapMargins];
+    [_yoga calculateLayoutWithSize:constrainedSize];
+    GMFlexCaptureRecorderRef recorder = GMFlexCaptureRecorderStart(_yoga.node);
+    if (recorder == NULL) {
+        return NO;
+    }
+    YGNodeCalculateLayout(_yoga.node, constrainedSize.width, constrainedSize.height, YGNodeStyleGetDirection(_yoga.node));
+    
+    // YogaKit's global configuration, see +[YGLayout initialize].
+    const GMFlexCaptureConfig config = {
+        .pointScaleFactor = GMFlexScreenScale(),
+        .experimentalFeatures = 1 << YGExperimentalFeatureWebFlexBasis,
+    };
+    FILE *file = fopen(path.fileSystemRepresentation, "w");
+    BOOL success = file != NULL &&
+                   GMFlexCaptureWrite(_yoga.node, (int)mode, constrainedSize.width, constrainedSize.height, &config,
+                                      GMFlexGapContainers.count > 0 || GMFlexGapItems.count > 0 ? GMFlexCaptureGapsOfNode : NULL,
+                                      recorder, file);
+    GMFlexCaptureRecorderFree(recorder);
+    return file != NULL && fclose(file) == 0 && success;
+}
+
+- (BOOL)layoutWithMode:(GMFlexLayoutMode)mode budget:(NSTimeInterval)budget progressive:(BOOL)progressive
+{
+    NSAssert(!_isDetached, @"A detached flex tree must be laid out with layoutWithSize:mode:");
+    NSAssert([NSThread isMainThread], @"A flex item attached to a view must be laid out on the main thread");
+    
+    const CFTimeInterval deadline = CACurrentMediaTime() + budget;
+    const CGSize size = self.view.bounds.size;
+    
+    if (_budgetedSubtrees == nil || _budgetedMode != mode || !CGSizeEqualToSize(_budgetedSize, size)) {
+        if ([self indexOfCachedLayoutWithMode:mode] != NSNotFound) {
+            [self layoutWithMode:mode];
+            return YES;
+        }
+        
+        // YogaKit gives the root the container width, less its margins, unless it has its own width.
+        YGNodeRef node = _yoga.node;
+        const YGValue styleWidth = YGNodeStyleGetWidth(node);
+        CGFloat width = NAN;
+        CGFloat margins;
+        if (styleWidth.unit == YGUnitPoint) {
+            width = styleWidth.value;
+        } else if (mode != GMFlexLayoutModeAdjustWidth && GMFlexHorizontalEdgesLength(node, YGNodeStyleGetMargin, &margins)) {
+            width = size.width - margins;
+        }
+        
+        // Subtrees are calculated with their gap margins.
+        [self applyGapMargins];
+        
+        NSPointerArray *subtrees = [NSPointerArray weakObjectsPointerArray];
+        NSMutableData *ownerWidths = [NSMutableData data];
+        GMFlexCollectPresolvableSubtrees(self.view, GMFlexInnerWidth(node, width), subtrees, ownerWidths);
+        _budgetedSubtrees = subtrees;
+        _budgetedOwnerWidths = ownerWidths;
+        _budgetedIndex = 0;
+        _budgetedMode = mode;
+        _budgetedSize = size;
+    }
+    
+    // Each call makes progress, whatever the budget.
+    BOOL hasCalculated = NO;
+    const CGFloat *ownerWidths = _budgetedOwnerWidths.bytes;
+    while (_budgetedIndex < _budgetedSubtrees.count && (!hasCalculated || CACurrentMediaTime() < deadline)) {
+        UIView *subtree = [_budgetedSubtrees pointerAtIndex:_budgetedIndex];
+        const CGFloat ownerWidth = ownerWidths[_budgetedIndex];
+        _budgetedIndex++;
+        
+        // The tree may have been modified since the pass started.
+        YGLayout *yoga = subtree.yoga;
+        if (subtree == nil || !yoga.isEnabled || !yoga.isIncludedInLayout || yoga.isLeaf || ![subtree isDescendantOfView:self.view]) {
+            continue;
+        }
+        
+        // Yoga keeps the subtree layout, reused when the whole tree is calculated with the same constraints. Solved as
+        // a root, the subtree was positioned at its margins: its parent, dirty, positions it again in the next solve
+        // instead of reusing its own cached layout.
+        [yoga calculateLayoutWithSize:CGSizeMake(ownerWidth, YGUndefined)];
+        GMFlexMarkContainerDirty(subtree.superview.yoga.node);
+        hasCalculated = YES;
+        
+        if (progressive) {
+            NSMutableArray<UIView *> *views = [NSMutableArray array];
+            GMFlexCollectLayoutViews(subtree, views);
+            for (UIView *view in views) {
+                view.frame = GMFlexFrameOfNode(view.yoga.node, CGPointZero);
+            }
+        }
+    }
+    
+    if (_budgetedIndex < _budgetedSubtrees.count || (hasCalculated && CACurrentMediaTime() >= deadline)) {
+        return NO;
+    }
+    [self layoutWithMode:mode];
+    return YES;
+}
+
+/**
+ Lays out a wrapping container whose children have the same fixed size style, without solving its Yoga tree, see
+ `GMFlexGridLayout`. Children having their own subtree are laid out separately, as long as their frames are pixel
+ aligned so that the result doesn't depend on their position.
+ 
+ - Returns: NO if the container isn't eligible, nothing was changed then.
+ */
+- (BOOL)layoutHomogeneousGridWithMode:(GMFlexLayoutMode)mode
+{
+    if (YGNodeStyleGetFlexWrap(_yoga.node) != YGWrapWrap) {
+        return NO;
+    }
+    
+    NSMutableArray<UIView *> *items = [NSMutableArray array];
+    for (UIView *subview in self.view.subviews) {
+        if (subview.isYogaEnabled && subview.yoga.isEnabled && subview.yoga.isIncludedInLayout) {
+            [items addObject:subview];
+        }
+    }
+    if (items.count == 0) {
+        return NO;
+    }
+    
+    NSMutableData *nodes = [NSMutableData dataWithLength:items.count * sizeof(YGNodeRef)];
+    NSMutableData *frames = [NSMutableData dataWithLength:items.count * sizeof(GMFlexGridFrame)];
+    YGNodeRef *itemNodes = nodes.mutableBytes;
+    [items enumerateObjectsUsingBlock:^(UIView *item, NSUInteger index, BOOL *stop) {
+        itemNodes[index] = item.yoga.node;
+    }];
+    
+    const CGRect frame = self.view.frame;
+    const CGSize size = self.view.bounds.size;
+    GMFlexGridLayoutResult result;
+    if (!GMFlexGridLayout(_yoga.node, itemNodes, items.count,
+                          mode == GMFlexLayoutModeAdjustWidth ? YGUndefined : size.width,
+                          mode == GMFlexLayoutModeAdjustHeight ? YGUndefined : size.height,
+                          GMFlexScreenScale(), frames.mutableBytes, &result)) {
+        return NO;
+    }
+    if (!result.isOnPixelGrid) {
+        for (UIView *item in items) {
+            if (!item.yoga.isLeaf) {
+                return NO;
+            }
+        }
+    }
+    
+    // Same frames as YogaKit, the root keeping its origin.
+    if (mode != GMFlexLayoutModeFitContainer) {
+        const CGPoint bottomRight = CGPointMake(frame.origin.x + result.width, frame.origin.y + result.height);
+        self.view.frame = CGRectMake(GMFlexRoundPixelValue(frame.origin.x),
+                                     GMFlexRoundPixelValue(frame.origin.y),
+                                     GMFlexRoundPixelValue(bottomRight.x) - GMFlexRoundPixelValue(frame.origin.x),
+                                     GMFlexRoundPixelValue(bottomRight.y) - GMFlexRoundPixelValue(frame.origin.y));
+    }
+    
+    // Item subtrees are solved as roots, placed at their margins: their views are positioned relative to the item, the
+    // item itself keeping its grid frame.
+    const GMFlexGridFrame *itemFrames = frames.bytes;
+    NSMutableArray<UIView *> *views = [NSMutableArray array];
+    [items enumerateObjectsUsingBlock:^(UIView *item, NSUInteger index, BOOL *stop) {
+        const GMFlexGridFrame itemFrame = itemFrames[index];
+        item.frame = CGRectMake(GMFlexRoundPixelValue(itemFrame.left),
+                                GMFlexRoundPixelValue(itemFrame.top),
+                                GMFlexRoundPixelValue(itemFrame.left + itemFrame.width) - GMFlexRoundPixelValue(itemFrame.left),
+                                GMFlexRoundPixelValue(itemFrame.top + itemFrame.height) - GMFlexRoundPixelValue(itemFrame.top));
+        if (!item.yoga.isLeaf) {
+            [item.yoga calculateLayoutWithSize:item.frame.size];
+            GMFlexCollectLayoutViews(item, views);
+        }
+    }];
+    for (UIView *view in views) {
+        view.frame = GMFlexFrameOfNode(view.yoga.node, CGPointZero);
+    }
+    
+    // The container wasn't solved: the next solve must position the items again rather than reuse its cached layout.
+    GMFlexMarkContainerDirty(_yoga.node);
+    return YES;
+}
+
+#pragma mark - Layout cache
+
+- (void)setLayoutCacheCapacity:(NSUInteger)layoutCacheCapacity
+{
+    _layoutCacheCapacity = layoutCacheCapacity;
+    
+    NSUInteger count = _layoutCache.count;
+    if (count > layoutCacheCapacity) {
+        [_layoutCache removeObjectsInRange:NSMakeRange(layoutCacheCapacity, count - layoutCacheCapacity)];
+        [self layoutCacheCountDidChangeFrom:count];
+    }
+}
+
+- (void)layoutCacheCountDidChangeFrom:(NSUInteger)previousCount
+{
+    if (previousCount == 0 && _layoutCache.count > 0) {
+        GMFlexLayoutCachingItemCount++;
+    } else if (previousCount > 0 && _layoutCache.count == 0) {
+        GMFlexLayoutCachingItemCount--;
+    }
+}
+
+- (void)invalidateCachedLayouts
+{
+    [self invalidateCachedLayoutsAppendingItem:NO];
+}
+
+/**
+ Drops the cached layouts of the receiver and of all its ancestors, since they all include the receiver frame. Append
+ baselines are dropped only when one of their earlier items, or the container itself, is modified.
+ 
+ - Parameter isAppending: YES if the receiver was only modified by the addition of its last item.
+ */
+- (void)invalidateCachedLayoutsAppendingItem:(BOOL)isAppending
+{
+    if (GMFlexLayoutCachingItemCount == 0) {
+        return;
+    }
+    
+    GMFlex *child = nil;
+    for (UIView *view = self.view; view != nil; view = view.superview) {
+        GMFlex *flex = GMFlexOfView(view);
+        if (flex == nil) {
+            child = nil;
+            continue;
+        }
+        
+        if (flex->_layoutCache.count > 0) {
+            [flex->_layoutCache removeAllObjects];
+            GMFlexLayoutCachingItemCount--;
+        }
+        if (flex->_hasAppendBaseline && (child != nil ? child->_isAppendBaselined : !isAppending)) {
+            [flex clearAppendBaseline];
+        }
+        child = flex;
+    }
+}
+
+- (void)cacheLayoutWithMode:(GMFlexLayoutMode)mode
+            constrainedSize:(CGSize)constrainedSize
+             previousOrigin:(CGPoint)previousOrigin
+                   capacity:(NSUInteger)capacity
+{
+    NSMutableArray<UIView *> *views = [NSMutableArray array];
+    GMFlexCollectLayoutViews(self.view, views);
+    
+    NSPointerArray *weakViews = [NSPointerArray weakObjectsPointerArray];
+    NSMutableData *frames = [NSMutableData dataWithLength:views.count * sizeof(CGRect)];
+    CGRect *rects = frames.mutableBytes;
+    [views enumerateObjectsUsingBlock:^(UIView *view, NSUInteger idx, BOOL *stop) {
+        [weakViews addPointer:(__bridge void *)view];
+        rects[idx] = view.frame;
+    }];
+    
+    CGRect frame = self.view.frame;
+    GMFlexLayoutCacheEntry *entry = [GMFlexLayoutCacheEntry new];
+    entry.mode = mode;
+    entry.constrainedSize = constrainedSize;
+    entry.originOffset = CGPointMake(frame.origin.x - previousOrigin.x, frame.origin.y - previousOrigin.y);
+    entry.size = frame.size;
+    entry.views = weakViews;
+    entry.frames = frames;
+    [entry countBytes];
+    
+    if (_layoutCache == nil) {
+        _layoutCache = [NSMutableArray arrayWithCapacity:capacity];
+    }
+    NSUInteger count = _layoutCache.count;
+    [_layoutCache insertObject:entry atIndex:0];
+    if (_layoutCache.count > capacity) {
+        [_layoutCache removeLastObject];
+    }
+    [self layoutCacheCountDidChangeFrom:count];
+}
+
+/**
+ Returns the index of the cached layout matching the current container size, or NSNotFound.
+ */
+- (NSUInteger)indexOfCachedLayoutWithMode:(GMFlexLayoutMode)mode
+{
+    CGSize constrainedSize = GMFlexConstrainedSize(self.view.bounds.size, mode);
+    return [_layoutCache indexOfObjectPassingTest:^BOOL(GMFlexLayoutCacheEntry *entry, NSUInteger idx, BOOL *stop) {
+        return entry.mode == mode && CGSizeEqualToSize(entry.constrainedSize, constrainedSize);
+    }];
+}
+
+/**
+ Applies the cached frames matching the current container size, if any.
+ 
+ - Returns: YES if the frames were restored, NO if the tree must be laid out.
+ */
+- (BOOL)restoreCachedLayoutWithMode:(GMFlexLayoutMode)mode
+{
+    NSUInteger index = [self indexOfCachedLayoutWithMode:mode];
+    if (index == NSNotFound) {
+        return NO;
+    }
+    
+    // The view hierarchy may have been modified without going through the flex interface.
+    GMFlexLayoutCacheEntry *entry = _layoutCache[index];
+    NSMutableArray<UIView *> *views = [NSMutableArray arrayWithCapacity:entry.views.count];
+    GMFlexCollectLayoutViews(self.view, views);
+    BOOL matches = views.count == entry.views.count;
+    for (NSUInteger i = 0; matches && i < views.count; i++) {
+        matches = [entry.views pointerAtIndex:i] == (__bridge void *)views[i];
+    }
+    if (!matches) {
+        [_layoutCache removeObjectAtIndex:index];
+        [self layoutCacheCountDidChangeFrom:_layoutCache.count + 1];
+        return NO;
+    }
+    
+    CGRect frame = self.view.frame;
+    frame.origin.x += entry.originOffset.x;
+    frame.origin.y += entry.originOffset.y;
+    frame.size = entry.size;
+    self.view.frame = frame;
+    
+    const CGRect *rects = entry.frames.bytes;
+    [views enumerateObjectsUsingBlock:^(UIView *view, NSUInteger idx, BOOL *stop) {
+        view.frame = rects[idx];
+    }];
+    
+    if (index != 0) {
+        [_layoutCache removeObjectAtIndex:index];
+        [_layoutCache insertObject:entry atIndex:0];
+    }
+    return YES;
+}
+
+#pragma mark - Layout memory
+
+- (NSUInteger)releaseLayoutMemory
+{
+    NSAssert(!_isDetached, @"A detached flex tree holds no cached layout");
+    NSAssert([NSThread isMainThread], @"A flex item attached to a view must be modified on the main thread");
+    
+    NSMutableArray<UIView *> *views = [NSMutableArray arrayWithObject:self.view];
+    NSUInteger releasedBytes = 0;
+    for (NSUInteger i = 0; i < views.count; i++) {
+        for (UIView *subview in views[i].subviews) {
+            if (GMFlexOfView(subview) != nil) {
+                [views addObject:subview];
+            }
+        }
+        
+        GMFlex *flex = GMFlexOfView(views[i]);
+        const NSUInteger count = flex->_layoutCache.count;
+        for (GMFlexLayoutCacheEntry *entry in flex->_layoutCache) {
+            releasedBytes += entry.byteCount;
+        }
+        flex->_layoutCache = nil;
+        [flex layoutCacheCountDidChangeFrom:count];
+        
+        // A pending budgeted pass starts again, an append baseline is recorded again by the next whole layout.
+        releasedBytes += flex->_budgetedSubtrees.count * sizeof(void *) + flex->_budgetedOwnerWidths.length;
+        flex->_budgetedSubtrees = nil;
+        flex->_budgetedOwnerWidths = nil;
+        [flex clearAppendBaseline];
+    }
+    
+    GMFlexLayoutMemory.releasedBytes += releasedBytes;
+    return releasedBytes;
+}
+
++ (GMFlexLayoutMemoryStatistics)layoutMemoryStatistics
+{
+    return GMFlexLayoutMemory;
+}
+
+- (void)releaseTree
+{
+    [self releaseLayoutMemory];
+    
+    // Each container resets the owner of its children at once, YogaKit attaches them again on the next layout.
+    NSMutableArray<UIView *> *views = [NSMutableArray arrayWithObject:self.view];
+    for (NSUInteger i = 0; i < views.count; i++) {
+        for (UIView *subview in views[i].subviews) {
+            if (subview.isYogaEnabled) {
+                [views addObject:subview];
+            }
+        }
+        YGNodeRemoveAllChildren(views[i].yoga.node);
+    }
+}
+
+#pragma mark - Append baseline
+
+- (void)layoutAppendedItems
+{
+    NSAssert(!_isDetached, @"A detached flex tree must be laid out with layoutWithSize:mode:");
+    NSAssert([NSThread isMainThread], @"A flex item attached to a view must be laid out on the main thread");
+    
+    UIView *view = self.view;
+    NSArray<UIView *> *subviews = view.subviews;
+    YGNodeRef node = _yoga.node;
+    if (!_hasAppendBaseline ||
+        view.bounds.size.width != _appendBaselineWidth ||
+        subviews.count < _appendBaselineSubviewCount ||
+        (_appendBaselineSubviewCount > 0 && subviews[_appendBaselineSubviewCount - 1] != _appendBaselineLastSubview) ||
+        YGNodeGetChildCount(node) != _appendBaselineItemCount) {
+        [self layoutWithMode:GMFlexLayoutModeAdjustHeight];
+        [self recordAppendBaseline];
+        return;
+    }
+    
+    NSMutableArray<UIView *> *items = [NSMutableArray array];
+    for (NSUInteger i = _appendBaselineSubviewCount; i < subviews.count; i++) {
+        UIView *subview = subviews[i];
+        if (subview.isYogaEnabled && subview.yoga.isEnabled && subview.yoga.isIncludedInLayout) {
+            [items addObject:subview];
+        }
+    }
+    
+    // New items get the gap of the column and their own gaps, earlier items keep theirs.
+    if (GMFlexGapContainers.count > 0 || GMFlexGapItems.count > 0) {
+        GMFlexSyncGaps(self, GMFlexInheritedDirection(self), NO);
+        for (UIView *item in items) {
+            GMFlex *flex = GMFlexOfView(item);
+            GMFlexSyncGaps(flex, GMFlexInheritedDirection(flex), YES);
+        }
+    }
+    
+    // YogaKit attaches the subtree of each new item, and sets the leaves measure function, when calculating it. The
+    // width given is only a hint for Yoga's cache, the item is calculated again inside the container.
+    const CGFloat innerWidth = view.bounds.size.width
+        - YGNodeLayoutGetPadding(node, YGEdgeLeft) - YGNodeLayoutGetPadding(node, YGEdgeRight)
+        - YGNodeLayoutGetBorder(node, YGEdgeLeft) - YGNodeLayoutGetBorder(node, YGEdgeRight);
+    BOOL isBaselineExtensible = YES;
+    for (UIView *item in items) {
+        YGLayout *yoga = item.yoga;
+        [yoga calculateLayoutWithSize:CGSizeMake(innerWidth, YGUndefined)];
+        YGNodeInsertChild(node, yoga.node, YGNodeGetChildCount(node));
+        isBaselineExtensible = isBaselineExtensible && yoga.position != YGPositionTypeAbsolute;
+    }
+    
+    // Earlier items are clean, Yoga reuses their cached layout and gives them their previous positions.
+    YGNodeCalculateLayout(node, view.bounds.size.width, YGUndefined, YGNodeStyleGetDirection(node));
+    view.frame = GMFlexFrameOfNode(node, view.frame.origin);
+    
+    NSMutableArray<UIView *> *views = [NSMutableArray array];
+    for (UIView *item in items) {
+        [views addObject:item];
+        if (!item.yoga.isLeaf) {
+            GMFlexCollectLayoutViews(item, views);
+        }
+    }
+    for (UIView *itemView in views) {
+        itemView.frame = GMFlexFrameOfNode(itemView.yoga.node, CGPointZero);
+    }
+    
+    if (!isBaselineExtensible) {
+        [self clearAppendBaseline];
+        return;
+    }
+    for (UIView *item in items) {
+        item.flex->_isAppendBaselined = YES;
+    }
+    _appendBaselineSubviewCount = subviews.count;
+    _appendBaselineLastSubview = subviews.lastObject;
+    _appendBaselineItemCount += items.count;
+}
+
+/**
+ Records the current layout of a column as the baseline of the next `layoutAppendedItems`, if appending items can't
+ move the earlier ones. Called after a whole layout.
+ */
+- (void)recordAppendBaseline
+{
+    YGNodeRef node = _yoga.node;
+    if (YGNodeStyleGetFlexDirection(node) != YGFlexDirectionColumn ||
+        YGNodeStyleGetFlexWrap(node) != YGWrapNoWrap ||
+        YGNodeStyleGetJustifyContent(node) != YGJustifyFlexStart ||
+        (YGNodeStyleGetHeight(node).unit != YGUnitUndefined && YGNodeStyleGetHeight(node).unit != YGUnitAuto) ||
+        YGNodeStyleGetMinHeight(node).unit != YGUnitUndefined ||
+        YGNodeStyleGetMaxHeight(node).unit != YGUnitUndefined ||
+        !YGFloatIsUndefined(YGNodeStyleGetAspectRatio(node))) {
+        return;
+    }
+    
+    // The Yoga tree must be the one of the view hierarchy, as attached by the whole layout.
+    NSMutableArray<GMFlex *> *items = [NSMutableArray array];
+    for (UIView *subview in self.view.subviews) {
+        if (subview.isYogaEnabled && subview.yoga.isEnabled && subview.yoga.isIncludedInLayout) {
+            if (subview.yoga.position == YGPositionTypeAbsolute) {
+                return;
+            }
+            [items addObject:subview.flex];
+        }
+    }
+    if (YGNodeGetChildCount(node) != items.count ||
+        (items.count > 0 && YGNodeGetChild(node, (uint32_t)items.count - 1) != items.lastObject->_yoga.node)) {
+        return;
+    }
+    
+    for (GMFlex *item in items) {
+        item->_isAppendBaselined = YES;
+    }
+    if (!_hasAppendBaseline) {
+        GMFlexLayoutCachingItemCount++;
+    }
+    _hasAppendBaseline = YES;
+    _appendBaselineWidth = self.view.bounds.size.width;
+    _appendBaselineSubviewCount = self.view.subviews.count;
+    _appendBaselineLastSubview = self.view.subviews.lastObject;
+    _appendBaselineItemCount = items.count;
+}
+
+- (void)clearAppendBaseline
+{
+    if (_hasAppendBaseline) {
+        _hasAppendBaseline = NO;
+        _appendBaselineLastSubview = nil;
+        GMFlexLayoutCachingItemCount--;
+    }
+}
+
+#pragma mark - Static layout
+
+- (void)applyFrames:(const CGRect *)frames count:(NSUInteger)count
+{
+    NSAssert(!_isDetached, @"A detached flex tree has no view to frame");
+    NSAssert([NSThread isMainThread], @"A flex item attached to a view must be laid out on the main thread");
+    
+    UIView *view = self.view;
+    NSMutableArray<UIView *> *views = [NSMutableArray array];
+    GMFlexCollectLayoutViews(view, views);
+    NSAssert(count == views.count + 1, @"The frame table has %lu frames, the flex tree %lu items",
+             (unsigned long)count, (unsigned long)views.count + 1);
+    if (count != views.count + 1) {
+        return;
+    }
+    
+    // The view hierarchy no longer holds the frames calculated by Yoga.
+    [self clearAppendBaseline];
+    // Like YogaKit preserving the origin: the root is offset by its margins, the first frame origin.
+    const CGRect rootFrame = frames[0];
+    view.frame = CGRectMake(GMFlexRoundPixelValue(view.frame.origin.x + rootFrame.origin.x),
+                            GMFlexRoundPixelValue(view.frame.origin.y + rootFrame.origin.y),
+                            rootFrame.size.width,
+                            rootFrame.size.height);
+    [views enumerateObjectsUsingBlock:^(UIView *itemView, NSUInteger index, BOOL *stop) {
+        itemView.frame = frames[index + 1];
+    }];
+}
+
+#pragma mark - Layout direction mirroring
+
+static inline BOOL GMFlexValuesEqual(YGValue a, YGValue b)
+{
+    return a.unit == b.unit && (a.unit == YGUnitUndefined || a.unit == YGUnitAuto || a.value == b.value);
+}
+
+/**
+ Returns YES if the RTL layout of an item is the mirror of its LTR layout: its physical left and right edges are equal
+ and, unless it's the root, it inherits its direction. The root must also have equal start and end margins to keep
+ its position.
+ 
+ A gap margin doesn't count: it faces the previous item, on the left in LTR rows and on the right in RTL ones, like
+ the mirror does.
+ */
+static BOOL GMFlexIsMirrorSymmetric(GMFlex *flex, BOOL isRoot)
 {
-    return _yoga.intrinsicSize;
+    YGNodeRef node = flex->_yoga.node;
+    if (!isRoot && YGNodeStyleGetDirection(node) != YGDirectionInherit) {
+        return NO;
+    }
+    
+    YGValue marginLeft = YGNodeStyleGetMargin(node, YGEdgeLeft);
+    YGValue marginRight = YGNodeStyleGetMargin(node, YGEdgeRight);
+    if (flex->_gapMargin.amount != 0 && flex->_gapMargin.edge == YGEdgeLeft) {
+        marginLeft = flex->_gapMargin.original;
+    } else if (flex->_gapMargin.amount != 0 && flex->_gapMargin.edge == YGEdgeRight) {
+        marginRight = flex->_gapMargin.original;
+    }
+    
+    const float borderLeft = YGNodeStyleGetBorder(node, YGEdgeLeft);
+    const float borderRight = YGNodeStyleGetBorder(node, YGEdgeRight);
+    return GMFlexValuesEqual(marginLeft, marginRight) &&
+           GMFlexValuesEqual(YGNodeStyleGetPadding(node, YGEdgeLeft), YGNodeStyleGetPadding(node, YGEdgeRight)) &&
+           GMFlexValuesEqual(YGNodeStyleGetPosition(node, YGEdgeLeft), YGNodeStyleGetPosition(node, YGEdgeRight)) &&
+           (borderLeft == borderRight || (YGFloatIsUndefined(borderLeft) && YGFloatIsUndefined(borderRight))) &&
+           (!isRoot || GMFlexValuesEqual(YGNodeStyleGetMargin(node, YGEdgeStart), YGNodeStyleGetMargin(node, YGEdgeEnd)));
 }
 
-#pragma mark - Lifecycle
+/**
+ Mirrors the frames of a cached layout horizontally, each view in its superview.
+ 
+ - Returns: NO if a view of the entry was deallocated or moved out of the tree.
+ */
+static BOOL GMFlexMirrorCacheEntry(GMFlexLayoutCacheEntry *entry, UIView *root)
+{
+    NSMutableData *frames = [entry.frames mutableCopy];
+    CGRect *rects = frames.mutableBytes;
+    NSMapTable<UIView *, NSNumber *> *widths = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsObjectPointerPersonality
+                                                                     valueOptions:NSPointerFunctionsStrongMemory];
+    [widths setObject:@(entry.size.width) forKey:root];
+    
+    // Depth-first order, superviews come first.
+    for (NSUInteger i = 0; i < entry.views.count; i++) {
+        UIView *view = [entry.views pointerAtIndex:i];
+        NSNumber *superviewWidth = view != nil ? [widths objectForKey:view.superview] : nil;
+        if (superviewWidth == nil) {
+            return NO;
+        }
+        rects[i].origin.x = superviewWidth.doubleValue - CGRectGetMaxX(rects[i]);
+        [widths setObject:@(rects[i].size.width) forKey:view];
+    }
+    entry.frames = frames;
+    return YES;
+}
 
-- (instancetype)initWithView:(UIView *)view
+/**
+ Sets the direction of a root having cached layouts without dropping them. Switching between LTR and RTL mirrors
+ them, if every item of the tree is mirror symmetric.
+ 
+ - Returns: NO if nothing was changed, the direction must be set like any property.
+ */
+- (BOOL)setLayoutDirectionMirroringCachedLayouts:(YGDirection)direction
 {
-    self = [super init];
-    if (self) {
-        self.view = view;
-        self.yoga = view.yoga;
+    if (_layoutCache.count == 0 || GMFlexOfView(self.view.superview) != nil) {
+        return NO;
+    }
+    NSAssert([NSThread isMainThread], @"A flex item attached to a view must be modified on the main thread");
+    
+    // The root resolves the inherit direction to LTR.
+    const BOOL wasRTL = _yoga.direction == YGDirectionRTL;
+    const BOOL isRTL = direction == YGDirectionRTL;
+    if (wasRTL != isRTL) {
+        NSMutableArray<UIView *> *views = [NSMutableArray array];
+        GMFlexCollectLayoutViews(self.view, views);
+        if (!GMFlexIsMirrorSymmetric(self, YES)) {
+            return NO;
+        }
+        for (UIView *view in views) {
+            if (!GMFlexIsMirrorSymmetric(view.flex, NO)) {
+                return NO;
+            }
+        }
         
-        // Enable flexbox and overwrite Yoga default values.
-        _yoga.isEnabled = YES;
-        _isIncludedInLayout = YES;
+        NSUInteger count = _layoutCache.count;
+        for (GMFlexLayoutCacheEntry *entry in [_layoutCache copy]) {
+            if (!GMFlexMirrorCacheEntry(entry, self.view)) {
+                [_layoutCache removeObject:entry];
+            }
+        }
+        [self layoutCacheCountDidChangeFrom:count];
+        [self clearAppendBaseline];
     }
-    return self;
+    
+    // Yoga calculates the tree again on the next layout missing the cache.
+    _yoga.direction = direction;
+    return YES;
 }
 
-#pragma mark - Flex item addition and definition
+#pragma mark - Invalidation tags
 
-- (GMFlex * (^)(void))addItem
+- (GMFlex * (^)(GMFlexInvalidationTag))invalidationTags
 {
-    return ^id(void) {
-        UIView *view = [UIView new];
-        return self.addItemView(view);
+    return ^id(GMFlexInvalidationTag tags) {
+        [self setInvalidationTags:tags];
+        return self;
     };
 }
 
-- (GMFlex * (^)(UIView *))addItemView
+- (void)addInvalidationTags:(GMFlexInvalidationTag)tags
 {
-    return ^id(UIView *view) {
-        NSAssert(self.view != nil, @"Trying to modify deallocated host view");
+    if ((_invalidationTags & tags) != tags) {
+        [self setInvalidationTags:_invalidationTags | tags];
+    }
+}
+
+/**
+ Sets the tags of the item and updates the index. Detached items are indexed once applied to views.
+ */
+- (void)setInvalidationTags:(GMFlexInvalidationTag)tags
+{
+    NSAssert(_isDetached || [NSThread isMainThread], @"A flex item attached to a view must be modified on the main thread");
+    
+    if (!_isDetached) {
+        for (NSUInteger bit = 0; bit < GMFLEX_INVALIDATION_TAG_COUNT; bit++) {
+            const GMFlexInvalidationTag tag = 1 << bit;
+            if ((tags & tag) && !(_invalidationTags & tag)) {
+                if (GMFlexTaggedItems[bit] == nil) {
+                    GMFlexTaggedItems[bit] = [NSHashTable weakObjectsHashTable];
+                }
+                [GMFlexTaggedItems[bit] addObject:self];
+            } else if (!(tags & tag) && (_invalidationTags & tag)) {
+                [GMFlexTaggedItems[bit] removeObject:self];
+            }
+        }
+    }
+    _invalidationTags = tags;
+}
+
++ (void)invalidateItemsWithTags:(GMFlexInvalidationTag)tags
+{
+    NSAssert([NSThread isMainThread], @"Flex items attached to a view must be invalidated on the main thread");
+    
+    NSHashTable<GMFlex *> *items = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+    for (NSUInteger bit = 0; bit < GMFLEX_INVALIDATION_TAG_COUNT; bit++) {
+        if ((tags & (1 << bit)) && GMFlexTaggedItems[bit] != nil) {
+            [items unionHashTable:GMFlexTaggedItems[bit]];
+        }
+    }
+    
+    NSHashTable<UIView *> *roots = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+    for (GMFlex *item in items) {
+        UIView *view = item.view;
         
-        [self.view addSubview:view];
-        return view.flex;
-    };
+        if (view == nil) {
+            continue;
+        }
+        
+        if (item->_yoga.isLeaf) {
+            // YogaKit sets the measure function before marking the node dirty.
+            [item->_yoga markDirty];
+        } else {
+            GMFlexMarkContainerDirty(item->_yoga.node);
+        }
+        [item invalidateCachedLayouts];
+        
+        UIView *root = view;
+        while (GMFlexOfView(root.superview) != nil) {
+            root = root.superview;
+        }
+        [roots addObject:root];
+    }
+    
+    // The layout of a root is driven by its superview, or its view controller's viewDidLayoutSubviews.
+    for (UIView *root in roots) {
+        [root.superview ?: root setNeedsLayout];
+    }
 }
 
-- (GMFlex * (^)(GMFlexDefine))define
+#pragma mark - Detached flex tree
+
+/**
+ Measure function of the detached leaves having a `measure` block.
+ */
+static YGSize GMFlexMeasureDetachedNode(YGNodeRef node, float width, YGMeasureMode widthMode, float height, YGMeasureMode heightMode)
 {
-    return ^id(GMFlexDefine closure){
-        closure(self);
-        return self;
+    GMFlex *flex = (__bridge GMFlex *)YGNodeGetContext(node);
+    const CGSize constrainedSize = {
+        .width = widthMode == YGMeasureModeUndefined ? CGFLOAT_MAX : width,
+        .height = heightMode == YGMeasureModeUndefined ? CGFLOAT_MAX : height,
+    };
+    const CGSize size = flex->_measure(constrainedSize);
+    
+    return (YGSize) {
+        .width = widthMode == YGMeasureModeExactly ? width : widthMode == YGMeasureModeAtMost ? MIN(size.width, width) : size.width,
+        .height = heightMode == YGMeasureModeExactly ? height : heightMode == YGMeasureModeAtMost ? MIN(size.height, height) : size.height,
     };
 }
 
-#pragma mark - Layout / intrinsicSize / sizeThatFits
-
-- (void)layout
+/**
+ Attaches the Yoga nodes of the included detached items to their parent, as YogaKit does from the view hierarchy.
+ */
+static void GMFlexSyncDetachedNodes(GMFlex *flex)
 {
-    [self layoutWithMode:GMFlexLayoutModeFitContainer];
+    YGNodeRef node = flex->_yoga.node;
+    NSMutableArray<GMFlex *> *items = [NSMutableArray arrayWithCapacity:flex->_detachedChildren.count];
+    for (GMFlex *item in flex->_detachedChildren) {
+        if (item->_isIncludedInLayout) {
+            [items addObject:item];
+        }
+    }
+    
+    // Yoga doesn't allow a measure function on a node having children.
+    YGMeasureFunc measureFunc = items.count == 0 && flex->_measure != nil ? GMFlexMeasureDetachedNode : NULL;
+    if (YGNodeGetMeasureFunc(node) != measureFunc) {
+        if (measureFunc != NULL) {
+            YGNodeRemoveAllChildren(node);
+        }
+        YGNodeSetMeasureFunc(node, measureFunc);
+    }
+    
+    BOOL isAttached = YGNodeGetChildCount(node) == items.count;
+    for (uint32_t i = 0; isAttached && i < items.count; i++) {
+        isAttached = YGNodeGetChild(node, i) == items[i]->_yoga.node;
+    }
+    if (!isAttached) {
+        YGNodeRemoveAllChildren(node);
+        [items enumerateObjectsUsingBlock:^(GMFlex *item, NSUInteger idx, BOOL *stop) {
+            YGNodeInsertChild(node, item->_yoga.node, (uint32_t)idx);
+        }];
+    }
+    
+    for (GMFlex *item in items) {
+        GMFlexSyncDetachedNodes(item);
+    }
 }
 
 /**
- The method layout the flex container's children
+ Copies the style of a detached item to the flex of a view, and applies its frame if it was laid out. Subviews are
+ matched to detached items by index, missing ones are created.
  
- - Parameter mode: specify the layout mod (LayoutMode).
+ YGNodeCopyStyle copies the whole style at once. Items whose style and gaps already equal the detached ones are left
+ untouched, the others lose their cached layouts, even when their node is already dirty: frames cached by
+ `attachToView:` are for the style that was copied then.
  */
-- (void)layoutWithMode:(GMFlexLayoutMode)mode
+static void GMFlexApplyDetachedItem(GMFlex *item, UIView *view, BOOL isRoot, BOOL appliesFrame)
 {
-    if (mode == GMFlexLayoutModeFitContainer) {
-        [_yoga applyLayoutPreservingOrigin:YES];
-    } else {
-        [_yoga applyLayoutPreservingOrigin:YES dimensionFlexibility:mode == GMFlexLayoutModeAdjustWidth ? YGDimensionFlexibilityFlexibleWidth : YGDimensionFlexibilityFlexibleHeight];
+    GMFlex *flex = view.flex;
+    YGNodeRef node = flex->_yoga.node;
+    if (!GMFlexStyleEqual(node, item->_yoga.node) || flex->_rowGap != item->_rowGap || flex->_columnGap != item->_columnGap) {
+        YGNodeCopyStyle(node, item->_yoga.node);
+        [flex invalidateCachedLayouts];
+    }
+    GMFlexCopyGaps(flex, item);
+    if (flex->_isIncludedInLayout != item->_isIncludedInLayout) {
+        flex.isIncludedInLayout = item->_isIncludedInLayout;
+    }
+    [flex addInvalidationTags:item->_invalidationTags];
+    
+    appliesFrame = appliesFrame && item->_isIncludedInLayout;
+    if (appliesFrame) {
+        view.frame = GMFlexFrameOfNode(item->_yoga.node, isRoot ? view.frame.origin : CGPointZero);
     }
+    
+    NSArray<UIView *> *subviews = view.subviews;
+    [item->_detachedChildren enumerateObjectsUsingBlock:^(GMFlex *child, NSUInteger idx, BOOL *stop) {
+        UIView *subview = idx < subviews.count ? subviews[idx] : nil;
+        if (subview == nil) {
+            subview = [UIView new];
+            [view addSubview:subview];
+        }
+        GMFlexApplyDetachedItem(child, subview, NO, appliesFrame);
+    }];
 }
 
-- (void)setIsIncludedInLayout:(BOOL)isIncludedInLayout
+static void GMFlexMarkDetachedItemAttached(GMFlex *item)
 {
-    _isIncludedInLayout = isIncludedInLayout;
-    _yoga.isIncludedInLayout = isIncludedInLayout;
+    item->_isAttached = YES;
+    for (GMFlex *child in item->_detachedChildren) {
+        GMFlexMarkDetachedItemAttached(child);
+    }
 }
 
-- (GMFlex * (^)(BOOL))flex_isIncludedInLayout
+/**
+ Returns YES if the Yoga tree of a detached item still holds the nodes of its included items, in order. Items added
+ or excluded since the last calculation aren't part of it, modifications of the others mark the root dirty.
+ */
+static BOOL GMFlexIsDetachedTreeSynced(GMFlex *flex)
+{
+    YGNodeRef node = flex->_yoga.node;
+    const uint32_t childCount = YGNodeGetChildCount(node);
+    uint32_t index = 0;
+    for (GMFlex *item in flex->_detachedChildren) {
+        if (!item->_isIncludedInLayout) {
+            continue;
+        }
+        if (index >= childCount || YGNodeGetChild(node, index) != item->_yoga.node || !GMFlexIsDetachedTreeSynced(item)) {
+            return NO;
+        }
+        index++;
+    }
+    return index == childCount;
+}
+
+static GMFlex *GMFlexCloneDetachedItem(GMFlex *item)
 {
-    return ^id(BOOL included) {
-        self.isIncludedInLayout = included;
-        return self;
-    };
+    GMFlex *clone = [GMFlex detachedFlex];
+    YGNodeCopyStyle(clone->_yoga.node, item->_yoga.node);
+    clone->_isIncludedInLayout = item->_isIncludedInLayout;
+    clone->_yoga.isIncludedInLayout = item->_isIncludedInLayout;
+    clone->_measure = item->_measure;
+    clone->_invalidationTags = item->_invalidationTags;
+    GMFlexCopyGaps(clone, item);
+    for (GMFlex *child in item->_detachedChildren) {
+        [clone->_detachedChildren addObject:GMFlexCloneDetachedItem(child)];
+    }
+    return clone;
+}
+
+- (void)layoutWithSize:(CGSize)size mode:(GMFlexLayoutMode)mode
+{
+    NSAssert(_isDetached, @"Only a detached flex tree can be laid out without its view, use layoutWithMode:");
+    NSAssert(!_isAttached, @"Trying to layout a detached flex tree after it was attached");
+    
+    [self applyGapMargins];
+    GMFlexSyncDetachedNodes(self);
+    YGNodeCalculateLayout(_yoga.node,
+                          mode == GMFlexLayoutModeAdjustWidth ? YGUndefined : size.width,
+                          mode == GMFlexLayoutModeAdjustHeight ? YGUndefined : size.height,
+                          YGNodeStyleGetDirection(_yoga.node));
+    
+    _hasDetachedLayout = YES;
+    _detachedLayoutMode = mode;
+    _detachedLayoutSize = size;
+}
+
+- (GMFlex * (^)(GMFlexMeasure))measure
+{
+    return ^id(GMFlexMeasure measure) {
+        NSAssert(self->_isDetached, @"Views measure themselves, measure() is only available on detached flex items");
+        NSAssert(!self->_isAttached, @"Trying to modify a detached flex tree after it was attached");
+        [self invalidateCachedLayouts];
+        self->_measure = [measure copy];
+        // The leaf is measured again, and the layout of the tree is no longer current.
+        GMFlexMarkContainerDirty(self->_yoga.node);
+        return self;
+    };
+}
+
+- (void)attachToView:(UIView *)view
+{
+    NSAssert([NSThread isMainThread], @"A detached flex tree must be attached on the main thread");
+    NSAssert(_isDetached && !_isAttached, @"Only a detached flex tree can be attached, and only once");
+    
+    // Frames are only applied if the tree wasn't modified since it was laid out.
+    const BOOL hasLayout = _hasDetachedLayout && !YGNodeIsDirty(_yoga.node) && GMFlexIsDetachedTreeSynced(self);
+    CGPoint origin = view.frame.origin;
+    GMFlexApplyDetachedItem(self, view, YES, hasLayout);
+    GMFlexMarkDetachedItemAttached(self);
+    
+    // The next layout of the view with the same size reuses the frames calculated in the background.
+    if (hasLayout) {
+        GMFlex *flex = view.flex;
+        [flex cacheLayoutWithMode:_detachedLayoutMode
+                  constrainedSize:GMFlexConstrainedSize(_detachedLayoutSize, _detachedLayoutMode)
+                   previousOrigin:origin
+                         capacity:MAX(flex.layoutCacheCapacity, 1)];
+    }
 }
 
-- (GMFlex * (^)(void))markDirty
+#pragma mark - Prototype
+
+- (void)applyToView:(UIView *)view
 {
-    return ^id {
-        [self.yoga markDirty];
-        return self;
-    };
+    NSAssert([NSThread isMainThread], @"A prototype must be applied on the main thread");
+    NSAssert(_isDetached, @"Only a detached flex tree can be used as a prototype");
+    
+    GMFlexApplyDetachedItem(self, view, YES, NO);
 }
 
-- (CGSize)sizeThatFits:(CGSize)size
+- (GMFlex *)clone
 {
-    return [_yoga calculateLayoutWithSize:size];
+    NSAssert(_isDetached, @"Only a detached flex tree can be cloned");
+    
+    return GMFlexCloneDetachedItem(self);
 }
 
 #pragma mark - Direction, wrap, flow
@@ -130,7 +1501,12 @@
 - (GMFlex * (^)(GMFlexWrapMode))wrap
 {
     return ^id(GMFlexWrapMode value) {
+        NSAssert(value == GMFlexNoWrap || (self->_rowGap == 0 && self->_columnGap == 0),
+                 @"Gaps aren't supported by wrapping containers");
         self.yoga.flexWrap = (YGWrap)value;
+        if (value != GMFlexNoWrap) {
+            [self setRowGap:0 columnGap:0];
+        }
         return self;
     };
 }
@@ -138,7 +1514,9 @@
 - (GMFlex * (^)(GMFlexLayoutDirection))layoutDirection
 {
     return ^id(GMFlexLayoutDirection value) {
-        self.yoga.direction = (YGDirection)value;
+        if (![self setLayoutDirectionMirroringCachedLayouts:(YGDirection)value]) {
+            self.yoga.direction = (YGDirection)value;
+        }
         return self;
     };
 }
@@ -233,6 +1611,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.width = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -257,6 +1636,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.height = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -308,6 +1688,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.minWidth = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -332,6 +1713,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.maxWidth = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -356,6 +1738,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.minHeight = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -380,6 +1763,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.maxHeight = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -411,6 +1795,70 @@
     };
 }
 
+- (GMFlex * (^)(NSData *))aspectRatioOfImageData
+{
+    return ^id(NSData *data) {
+        GMImageHeaderInfo info;
+        if (GMImageHeaderParse(data.bytes, data.length, &info) == GMImageHeaderStatusOK) {
+            self.yoga.aspectRatio = (CGFloat)info.width / info.height;
+        }
+        return self;
+    };
+}
+
+/**
+ Reads up to `length` bytes from a file. Returns nil on I/O errors, which `readDataOfLength:` raises as exceptions.
+ */
+static NSData *GMFlexReadFileData(NSFileHandle *fileHandle, NSUInteger length)
+{
+    if (@available(iOS 13.0, *)) {
+        return [fileHandle readDataUpToLength:length error:NULL];
+    }
+    @try {
+        return [fileHandle readDataOfLength:length];
+    } @catch (NSException *exception) {
+        return nil;
+    }
+}
+
+- (GMFlex * (^)(NSString *))aspectRatioOfImageFile
+{
+    return ^id(NSString *path) {
+        NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:path];
+        if (fileHandle == nil) {
+            return self;
+        }
+        
+        // Most headers fit in the first chunk, JPEG ones may be preceded by large EXIF or ICC segments.
+        NSMutableData *data = [NSMutableData data];
+        NSUInteger chunkLength = 4096;
+        GMImageHeaderInfo info;
+        GMImageHeaderStatus status = GMImageHeaderStatusNeedMoreData;
+        while (status == GMImageHeaderStatusNeedMoreData) {
+            NSData *chunk = GMFlexReadFileData(fileHandle, chunkLength);
+            if (chunk.length == 0) {
+                break;
+            }
+            [data appendData:chunk];
+            status = GMImageHeaderParse(data.bytes, data.length, &info);
+            chunkLength *= 2;
+        }
+        if (@available(iOS 13.0, *)) {
+            [fileHandle closeAndReturnError:NULL];
+        } else {
+            @try {
+                [fileHandle closeFile];
+            } @catch (NSException *exception) {
+            }
+        }
+        
+        if (status == GMImageHeaderStatusOK) {
+            self.yoga.aspectRatio = (CGFloat)info.width / info.height;
+        }
+        return self;
+    };
+}
+
 #pragma mark - Absolute positionning
 
 - (GMFlex * (^)(GMFlexPosition))position
@@ -433,6 +1881,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.left = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -449,6 +1898,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.top = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -465,6 +1915,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.right = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -481,6 +1932,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.bottom = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -497,6 +1949,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.start = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -513,6 +1966,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.end = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -531,6 +1985,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginTop = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -547,6 +2002,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginLeft = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -563,6 +2019,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginBottom = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -579,6 +2036,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginRight = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -595,6 +2053,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginStart = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -611,6 +2070,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginEnd = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -627,6 +2087,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginHorizontal = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -643,6 +2104,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.marginVertical = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -681,6 +2143,7 @@
 {
     return ^id(CGFloat value) {
         self.yoga.margin = YGValueMakeWithUnit(value, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -699,6 +2162,7 @@
     return ^id(CGFloat vertical, CGFloat horizontal) {
         self.yoga.marginVertical = YGValueMakeWithUnit(vertical, YGUnitPercent);
         self.yoga.marginHorizontal = YGValueMakeWithUnit(vertical, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -721,6 +2185,7 @@
         self.yoga.marginLeft = YGValueMakeWithUnit(left, YGUnitPercent);
         self.yoga.marginBottom = YGValueMakeWithUnit(bottom, YGUnitPercent);
         self.yoga.marginRight = YGValueMakeWithUnit(right, YGUnitPercent);
+        [self addInvalidationTags:GMFlexInvalidationTagPercentDependent];
         return self;
     };
 }
@@ -841,6 +2306,282 @@
     };
 }
 
+#pragma mark - Gap
+
+- (GMFlex * (^)(CGFloat))rowGap
+{
+    return ^id(CGFloat value) {
+        [self setRowGap:value columnGap:self->_columnGap];
+        return self;
+    };
+}
+
+- (GMFlex * (^)(CGFloat))columnGap
+{
+    return ^id(CGFloat value) {
+        [self setRowGap:self->_rowGap columnGap:value];
+        return self;
+    };
+}
+
+- (GMFlex * (^)(CGFloat))gap
+{
+    return ^id(CGFloat value) {
+        [self setRowGap:value columnGap:value];
+        return self;
+    };
+}
+
+/**
+ Adds a flex to a gap table, or removes it from the table.
+ */
+static void GMFlexSetGapTableMembership(NSHashTable<GMFlex *> * __strong *table, GMFlex *flex, BOOL isMember)
+{
+    if (isMember) {
+        if (*table == nil) {
+            *table = [NSHashTable weakObjectsHashTable];
+        }
+        [*table addObject:flex];
+    } else {
+        [*table removeObject:flex];
+    }
+}
+
+- (void)setRowGap:(CGFloat)rowGap columnGap:(CGFloat)columnGap
+{
+    if (rowGap == _rowGap && columnGap == _columnGap) {
+        return;
+    }
+    const BOOL isRejected = YGNodeStyleGetFlexWrap(_yoga.node) != YGWrapNoWrap && (rowGap != 0 || columnGap != 0);
+    NSAssert(!isRejected, @"Gaps aren't supported by wrapping containers");
+    if (isRejected) {
+        return;
+    }
+    
+    // Checks threading and drops the cached layouts. The margins of the items change on the next calculation, which
+    // dirties them.
+    (void)self.yoga;
+    _rowGap = rowGap;
+    _columnGap = columnGap;
+    if (!_isDetached) {
+        GMFlexSetGapTableMembership(&GMFlexGapContainers, self, _rowGap != 0 || _columnGap != 0);
+    } else {
+        // The layout of a detached tree is no longer current, see attachToView:.
+        GMFlexMarkContainerDirty(_yoga.node);
+    }
+}
+
+static inline BOOL GMFlexIsRowDirection(YGFlexDirection flexDirection)
+{
+    return flexDirection == YGFlexDirectionRow || flexDirection == YGFlexDirectionRowReverse;
+}
+
+/**
+ Returns the axis of a flex direction in a layout direction, rows being reversed in RTL like Yoga does.
+ */
+static YGFlexDirection GMFlexResolveFlexDirection(YGFlexDirection flexDirection, YGDirection direction)
+{
+    if (direction == YGDirectionRTL) {
+        if (flexDirection == YGFlexDirectionRow) {
+            return YGFlexDirectionRowReverse;
+        } else if (flexDirection == YGFlexDirectionRowReverse) {
+            return YGFlexDirectionRow;
+        }
+    }
+    return flexDirection;
+}
+
+/**
+ Returns the layout direction an attached container inherits from its flex ancestors, LTR at the root like YogaKit.
+ */
+static YGDirection GMFlexInheritedDirection(GMFlex *container)
+{
+    for (UIView *view = container.view.superview; GMFlexOfView(view) != nil; view = view.superview) {
+        const YGDirection direction = YGNodeStyleGetDirection(GMFlexOfView(view)->_yoga.node);
+        if (direction != YGDirectionInherit) {
+            return direction;
+        }
+    }
+    return YGDirectionLTR;
+}
+
+/**
+ Returns the margin edge Yoga reads for the leading side of a node along an axis: start in rows when it is set, the
+ physical edge otherwise.
+ */
+static YGEdge GMFlexLeadingMarginEdge(YGNodeRef node, YGFlexDirection axis)
+{
+    static const YGEdge leadingEdges[] = {YGEdgeTop, YGEdgeBottom, YGEdgeLeft, YGEdgeRight};
+    if (GMFlexIsRowDirection(axis) && YGNodeStyleGetMargin(node, YGEdgeStart).unit != YGUnitUndefined) {
+        return YGEdgeStart;
+    }
+    return leadingEdges[axis];
+}
+
+/**
+ Resolves the margin of a node on an edge, falling back to the horizontal or vertical margin and then to all margins
+ like Yoga does.
+ 
+ - Returns: NO if it isn't a point value.
+ */
+static BOOL GMFlexPointMargin(YGNodeRef node, YGEdge edge, float *margin)
+{
+    YGValue value = YGNodeStyleGetMargin(node, edge);
+    if (value.unit == YGUnitUndefined && edge != YGEdgeStart && edge != YGEdgeEnd) {
+        value = YGNodeStyleGetMargin(node, edge == YGEdgeLeft || edge == YGEdgeRight ? YGEdgeHorizontal : YGEdgeVertical);
+    }
+    if (value.unit == YGUnitUndefined) {
+        value = YGNodeStyleGetMargin(node, YGEdgeAll);
+    }
+    
+    if (value.unit == YGUnitUndefined) {
+        *margin = 0;
+        return YES;
+    }
+    *margin = value.value;
+    return value.unit == YGUnitPoint;
+}
+
+/**
+ Sets the gap margin of an item, restoring the previous one. Yoga marks the item dirty when its margin changes.
+ */
+static void GMFlexSetGapMargin(GMFlex *item, YGEdge edge, float amount)
+{
+    GMFlexGapMargin *gapMargin = &item->_gapMargin;
+    if (gapMargin->amount == amount && (amount == 0 || gapMargin->edge == edge)) {
+        return;
+    }
+    
+    YGNodeRef node = item->_yoga.node;
+    if (gapMargin->amount != 0) {
+        YGNodeStyleSetMargin(node, gapMargin->edge, gapMargin->original.unit == YGUnitPoint ? gapMargin->original.value : YGUndefined);
+        gapMargin->amount = 0;
+    }
+    
+    float margin;
+    const BOOL isPointMargin = GMFlexPointMargin(node, edge, &margin);
+    NSCAssert(amount == 0 || isPointMargin, @"The items of a container having gaps need a point margin, or none, facing the previous item");
+    if (amount != 0 && isPointMargin) {
+        gapMargin->edge = edge;
+        gapMargin->original = YGNodeStyleGetMargin(node, edge);
+        gapMargin->amount = amount;
+        YGNodeStyleSetMargin(node, edge, margin + amount);
+    }
+    
+    if (!item->_isDetached) {
+        GMFlexSetGapTableMembership(&GMFlexGapItems, item, gapMargin->amount != 0);
+    }
+}
+
+/**
+ Adds the gap of a container along its main axis to the margin of its items, on the side facing the previous item,
+ and removes the gap margins that no longer apply. Since every item but the first one gets the whole gap, Yoga
+ distributes the same free space as with CSS gaps. Wrapping containers don't get gaps, see `rowGap`: they can only
+ have some when made to wrap through YogaKit, and those are ignored.
+ 
+ - Parameter container: container, or root of the tree if `recursive`.
+ - Parameter direction: layout direction inherited by the container.
+ - Parameter recursive: YES to update the containers of the whole tree.
+ */
+static void GMFlexSyncGaps(GMFlex *container, YGDirection direction, BOOL recursive)
+{
+    YGNodeRef node = container->_yoga.node;
+    if (YGNodeStyleGetDirection(node) != YGDirectionInherit) {
+        direction = YGNodeStyleGetDirection(node);
+    }
+    
+    const YGFlexDirection flexDirection = YGNodeStyleGetFlexDirection(node);
+    const YGFlexDirection mainAxis = GMFlexResolveFlexDirection(flexDirection, direction);
+    float mainGap = GMFlexIsRowDirection(flexDirection) ? container->_columnGap : container->_rowGap;
+    if (YGNodeStyleGetFlexWrap(node) != YGWrapNoWrap) {
+        mainGap = 0;
+    }
+    
+    // Same items as the Yoga tree, in order.
+    const BOOL isDetached = container->_isDetached;
+    NSArray *children = isDetached ? container->_detachedChildren : container.view.subviews;
+    BOOL hasPreviousItem = NO;
+    for (id child in children) {
+        GMFlex *item = isDetached ? child : GMFlexOfView(child);
+        if (item == nil) {
+            continue;
+        }
+        YGNodeRef itemNode = item->_yoga.node;
+        const BOOL isIncluded = isDetached ? item->_isIncludedInLayout : item->_yoga.isEnabled && item->_yoga.isIncludedInLayout;
+        const BOOL isInFlow = isIncluded &&
+            YGNodeStyleGetPositionType(itemNode) != YGPositionTypeAbsolute &&
+            YGNodeStyleGetDisplay(itemNode) != YGDisplayNone;
+        
+        GMFlexSetGapMargin(item, GMFlexLeadingMarginEdge(itemNode, mainAxis), isInFlow && hasPreviousItem ? mainGap : 0);
+        hasPreviousItem = hasPreviousItem || isInFlow;
+        if (recursive && isIncluded) {
+            GMFlexSyncGaps(item, direction, YES);
+        }
+    }
+}
+
+/**
+ Applies the gap margins of the tree of the receiver, before it is calculated, walking its flex items. Attached trees
+ are left untouched while no attached item has gaps or a gap margin.
+ */
+- (void)applyGapMargins
+{
+    if (_isDetached) {
+        GMFlexSyncGaps(self, YGDirectionLTR, YES);
+        return;
+    }
+    if (GMFlexGapContainers.count == 0 && GMFlexGapItems.count == 0) {
+        return;
+    }
+    
+    // A margin left on the root by a container it was moved out of, or whose gaps were removed.
+    GMFlex *container = GMFlexOfView(self.view.superview);
+    if (container == nil || (container->_rowGap == 0 && container->_columnGap == 0)) {
+        [self removeGapMargins];
+    }
+    GMFlexSyncGaps(self, GMFlexInheritedDirection(self), YES);
+}
+
+/**
+ Removes the gap margin of the receiver, before its style is modified. It is added again by the next calculation.
+ */
+- (void)removeGapMargins
+{
+    if (_gapMargin.amount != 0) {
+        GMFlexSetGapMargin(self, _gapMargin.edge, 0);
+    }
+}
+
+/**
+ Returns the gaps of an attached node for a capture, see GMFlexCaptureWrite.
+ */
+static void GMFlexCaptureGapsOfNode(YGNodeRef node, GMFlexCaptureGaps *gaps)
+{
+    GMFlex *flex = GMFlexOfView((__bridge UIView *)YGNodeGetContext(node));
+    if (flex == nil) {
+        return;
+    }
+    gaps->rowGap = flex->_rowGap;
+    gaps->columnGap = flex->_columnGap;
+    gaps->hasGapMargin = flex->_gapMargin.amount != 0;
+    gaps->gapMarginEdge = flex->_gapMargin.edge;
+    gaps->gapMarginOriginal = flex->_gapMargin.original;
+}
+
+/**
+ Copies the gaps of a detached item and its gap margin, already part of the style copied from its node.
+ */
+static void GMFlexCopyGaps(GMFlex *flex, GMFlex *source)
+{
+    flex->_rowGap = source->_rowGap;
+    flex->_columnGap = source->_columnGap;
+    flex->_gapMargin = source->_gapMargin;
+    if (!flex->_isDetached) {
+        GMFlexSetGapTableMembership(&GMFlexGapContainers, flex, flex->_rowGap != 0 || flex->_columnGap != 0);
+        GMFlexSetGapTableMembership(&GMFlexGapItems, flex, flex->_gapMargin.amount != 0);
+    }
+}
+
 #pragma mark - UIView Visual properties
 
 - (GMFlex * (^)(UIColor *))backgroundColor
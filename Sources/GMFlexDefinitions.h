@@ -126,4 +126,16 @@ typedef NS_ENUM(int, GMFlexDisplay) {
     GMFlexDisplayNone = YGDisplayNone,
 };
 
+/**
+ Categories of flex items invalidated together by `+[GMFlex invalidateItemsWithTags:]`.
+ */
+typedef NS_OPTIONS(NSUInteger, GMFlexInvalidationTag) {
+    /// Items displaying text, whose size follows the content size category. Labels, text fields and text views are tagged automatically.
+    GMFlexInvalidationTagText = 1 << 0,
+    /// Items displaying images, whose size follows the theme or the trait collection. Image views are tagged automatically.
+    GMFlexInvalidationTagImage = 1 << 1,
+    /// Items having a percentage length. Tagged automatically by the percentage setters.
+    GMFlexInvalidationTagPercentDependent = 1 << 2,
+};
+
 #endif /* GMFlexDefinitions_h */
@@ -0,0 +1,473 @@
+//
+//  GMFlexStaticLayout.h
+//  FlexLayout-OC
+//
+//  Compile-time layout of static flex trees: every item has a fixed size, or takes the size of its content made of
+//  fixed size items, and nothing is measured. A tree is described with constexpr nodes, using the vocabulary of
+//  `GMFlexDefinitions.h`, and solved by the compiler into a constant frame table, applied with
+//  `-[GMFlex applyFrames:count:]`.
+//
+//  C++14, include it from Objective-C++ files only. It doesn't depend on UIKit, so that static layouts can be
+//  checked anywhere against Yoga, see `Tools/FlexStaticCheck`.
+//
+//  Example, a cell skeleton:
+//
+//      static constexpr gmflex::StaticNode cellNodes[] = {
+//          gmflex::StaticNode().direction(GMFlexDirectionRow).padding(12).alignItems(GMFlexAlignItemsCenter).items(2),
+//              gmflex::StaticNode().size(40, 40),
+//              gmflex::StaticNode().grow(1).height(20).marginLeft(8),
+//      };
+//      static constexpr auto cellFrames = gmflex::rects(gmflex::solve(cellNodes, 375, 64, 3));
+//      static_assert(cellFrames.rects[2].size.width == 303, "");
+//
+//      [cell.flex applyFrames:cellFrames.rects count:cellFrames.count];
+//
+//  Supported: direction, justifyContent, alignItems, alignSelf, grow, shrink, point width and height, point margins
+//  and paddings, in a left-to-right layout without wrapping. Items without a width or a height take the size of their
+//  content, or are stretched in the cross axis.
+//
+
+#ifndef GMFlexStaticLayout_h
+#define GMFlexStaticLayout_h
+
+#ifdef __cplusplus
+
+#include <stddef.h>
+
+#ifdef __OBJC__
+#import <CoreGraphics/CoreGraphics.h>
+#import "GMFlexDefinitions.h"
+#else
+#include <yoga/Yoga.h>
+
+// Same enums as GMFlexDefinitions.h, which needs Foundation.
+enum GMFlexDirection : int {
+    GMFlexDirectionColumn = YGFlexDirectionColumn,
+    GMFlexDirectionColumnReverse = YGFlexDirectionColumnReverse,
+    GMFlexDirectionRow = YGFlexDirectionRow,
+    GMFlexDirectionRowReverse = YGFlexDirectionRowReverse,
+};
+
+enum GMFlexJustifyContent : int {
+    GMFlexJustifyContentStart = YGJustifyFlexStart,
+    GMFlexJustifyContentCenter = YGJustifyCenter,
+    GMFlexJustifyContentEnd = YGJustifyFlexEnd,
+    GMFlexJustifyContentSpaceBetween = YGJustifySpaceBetween,
+    GMFlexJustifyContentSpaceAround = YGJustifySpaceAround,
+    GMFlexJustifyContentSpaceEvenly = YGJustifySpaceEvenly,
+};
+
+enum GMFlexAlignItems : int {
+    GMFlexAlignItemsStretch = YGAlignStretch,
+    GMFlexAlignItemsStart = YGAlignFlexStart,
+    GMFlexAlignItemsCenter = YGAlignCenter,
+    GMFlexAlignItemsEnd = YGAlignFlexEnd,
+};
+
+enum GMFlexAlignSelf : int {
+    GMFlexAlignSelfAuto = YGAlignAuto,
+    GMFlexAlignSelfStretch = YGAlignStretch,
+    GMFlexAlignSelfStart = YGAlignFlexStart,
+    GMFlexAlignSelfCenter = YGAlignCenter,
+    GMFlexAlignSelfEnd = YGAlignFlexEnd,
+};
+#endif
+
+namespace gmflex {
+
+/// Physical edges, indexed like YGEdge.
+enum StaticEdge : int {
+    StaticEdgeLeft = 0,
+    StaticEdgeTop = 1,
+    StaticEdgeRight = 2,
+    StaticEdgeBottom = 3,
+};
+
+struct StaticStyle {
+    GMFlexDirection direction = GMFlexDirectionColumn;
+    GMFlexJustifyContent justifyContent = GMFlexJustifyContentStart;
+    GMFlexAlignItems alignItems = GMFlexAlignItemsStretch;
+    GMFlexAlignSelf alignSelf = GMFlexAlignSelfAuto;
+    float grow = 0;
+    float shrink = 0;
+    // Negative if auto.
+    float width = -1;
+    float height = -1;
+    float margin[4] = {0, 0, 0, 0};
+    float padding[4] = {0, 0, 0, 0};
+    // Number of direct children, which follow the node in depth-first order.
+    size_t itemCount = 0;
+};
+
+/**
+ A node of a static tree. Nodes are listed in depth-first order, each one followed by its `items`.
+ */
+class StaticNode {
+public:
+    constexpr StaticNode() = default;
+
+    constexpr StaticNode direction(GMFlexDirection value) const { StaticNode node = *this; node.style.direction = value; return node; }
+    constexpr StaticNode justifyContent(GMFlexJustifyContent value) const { StaticNode node = *this; node.style.justifyContent = value; return node; }
+    constexpr StaticNode alignItems(GMFlexAlignItems value) const { StaticNode node = *this; node.style.alignItems = value; return node; }
+    constexpr StaticNode alignSelf(GMFlexAlignSelf value) const { StaticNode node = *this; node.style.alignSelf = value; return node; }
+    constexpr StaticNode grow(float value) const { StaticNode node = *this; node.style.grow = value; return node; }
+    constexpr StaticNode shrink(float value) const { StaticNode node = *this; node.style.shrink = value; return node; }
+    constexpr StaticNode width(float value) const { StaticNode node = *this; node.style.width = value; return node; }
+    constexpr StaticNode height(float value) const { StaticNode node = *this; node.style.height = value; return node; }
+    constexpr StaticNode size(float width, float height) const { return this->width(width).height(height); }
+
+    constexpr StaticNode marginLeft(float value) const { return edge(&StaticStyle::margin, StaticEdgeLeft, value); }
+    constexpr StaticNode marginTop(float value) const { return edge(&StaticStyle::margin, StaticEdgeTop, value); }
+    constexpr StaticNode marginRight(float value) const { return edge(&StaticStyle::margin, StaticEdgeRight, value); }
+    constexpr StaticNode marginBottom(float value) const { return edge(&StaticStyle::margin, StaticEdgeBottom, value); }
+    constexpr StaticNode marginHorizontal(float value) const { return marginLeft(value).marginRight(value); }
+    constexpr StaticNode marginVertical(float value) const { return marginTop(value).marginBottom(value); }
+    constexpr StaticNode margin(float value) const { return marginHorizontal(value).marginVertical(value); }
+
+    constexpr StaticNode paddingLeft(float value) const { return edge(&StaticStyle::padding, StaticEdgeLeft, value); }
+    constexpr StaticNode paddingTop(float value) const { return edge(&StaticStyle::padding, StaticEdgeTop, value); }
+    constexpr StaticNode paddingRight(float value) const { return edge(&StaticStyle::padding, StaticEdgeRight, value); }
+    constexpr StaticNode paddingBottom(float value) const { return edge(&StaticStyle::padding, StaticEdgeBottom, value); }
+    constexpr StaticNode paddingHorizontal(float value) const { return paddingLeft(value).paddingRight(value); }
+    constexpr StaticNode paddingVertical(float value) const { return paddingTop(value).paddingBottom(value); }
+    constexpr StaticNode padding(float value) const { return paddingHorizontal(value).paddingVertical(value); }
+
+    /// Number of direct children of the node, listed right after it.
+    constexpr StaticNode items(size_t count) const { StaticNode node = *this; node.style.itemCount = count; return node; }
+
+    StaticStyle style;
+
+private:
+    constexpr StaticNode edge(float (StaticStyle::*edges)[4], StaticEdge side, float value) const
+    {
+        StaticNode node = *this;
+        (node.style.*edges)[side] = value;
+        return node;
+    }
+};
+
+/// Frame of a node, relative to its parent, pixel aligned like Yoga does.
+struct StaticFrame {
+    float left = 0;
+    float top = 0;
+    float width = 0;
+    float height = 0;
+};
+
+template <size_t N>
+struct StaticFrameTable {
+    static constexpr size_t count = N;
+    StaticFrame frames[N];
+
+    constexpr const StaticFrame &operator[](size_t index) const { return frames[index]; }
+};
+
+namespace detail {
+
+/// Not constexpr: reaching it makes the compilation fail, or traps when the tree is solved at run time.
+[[noreturn]] inline void invalidStaticTree() { __builtin_trap(); }
+
+constexpr float absolute(float value)
+{
+    return value < 0 ? -value : value;
+}
+
+constexpr bool floatsEqual(float a, float b)
+{
+    return absolute(a - b) < 0.0001f;
+}
+
+constexpr float maximum(float a, float b)
+{
+    return a > b ? a : b;
+}
+
+/// Same as fmodf(value, 1.0f).
+constexpr float fraction(float value)
+{
+    return value - static_cast<float>(static_cast<long long>(value));
+}
+
+/// Same as Yoga's YGRoundValueToPixelGrid, without text rounding.
+constexpr float roundValueToPixelGrid(float value, float scale)
+{
+    float scaledValue = value * scale;
+    const float fractial = fraction(scaledValue);
+    if (floatsEqual(fractial, 0)) {
+        scaledValue = scaledValue - fractial;
+    } else if (floatsEqual(fractial, 1.0f)) {
+        scaledValue = scaledValue - fractial + 1.0f;
+    } else {
+        scaledValue = scaledValue - fractial + (fractial > 0.5f || floatsEqual(fractial, 0.5f) ? 1.0f : 0.0f);
+    }
+    return scaledValue / scale;
+}
+
+constexpr bool isRow(GMFlexDirection direction)
+{
+    return direction == GMFlexDirectionRow || direction == GMFlexDirectionRowReverse;
+}
+
+constexpr bool isReverse(GMFlexDirection direction)
+{
+    return direction == GMFlexDirectionRowReverse || direction == GMFlexDirectionColumnReverse;
+}
+
+/// Leading and trailing edges of an axis, reversed directions starting from the right or the bottom.
+constexpr StaticEdge leadingEdge(bool row, bool reverse)
+{
+    return row ? (reverse ? StaticEdgeRight : StaticEdgeLeft) : (reverse ? StaticEdgeBottom : StaticEdgeTop);
+}
+
+constexpr StaticEdge trailingEdge(bool row, bool reverse)
+{
+    return leadingEdge(row, !reverse);
+}
+
+constexpr float edgesLength(const float (&edges)[4], bool row)
+{
+    return row ? edges[StaticEdgeLeft] + edges[StaticEdgeRight] : edges[StaticEdgeTop] + edges[StaticEdgeBottom];
+}
+
+constexpr float styleSize(const StaticStyle &style, bool row)
+{
+    return row ? style.width : style.height;
+}
+
+/// Index following the subtree of `index`.
+constexpr size_t subtreeEnd(const StaticNode *nodes, size_t count, size_t index)
+{
+    size_t end = index + 1;
+    for (size_t i = 0; i < nodes[index].style.itemCount; i++) {
+        if (end >= count) {
+            invalidStaticTree(); // More items than nodes.
+        }
+        end = subtreeEnd(nodes, count, end);
+    }
+    return end;
+}
+
+/// Size of a node in an axis when it isn't flexed or stretched: its own size, or the size of its content.
+constexpr float contentSize(const StaticNode *nodes, size_t count, size_t index, bool row)
+{
+    const StaticStyle &style = nodes[index].style;
+    const float padding = edgesLength(style.padding, row);
+    if (styleSize(style, row) >= 0) {
+        return maximum(styleSize(style, row), padding);
+    }
+
+    const bool isMainAxis = isRow(style.direction) == row;
+    float content = 0;
+    size_t child = index + 1;
+    for (size_t i = 0; i < style.itemCount; i++) {
+        const float childSize = contentSize(nodes, count, child, row) + edgesLength(nodes[child].style.margin, row);
+        content = isMainAxis ? content + childSize : maximum(content, childSize);
+        child = subtreeEnd(nodes, count, child);
+    }
+    return padding + content;
+}
+
+/// Lays out the items of a node of the specified size, frames being relative to their parent and not rounded.
+constexpr void layoutItems(const StaticNode *nodes, size_t count, size_t index, float width, float height, StaticFrame *frames)
+{
+    const StaticStyle &style = nodes[index].style;
+    const bool row = isRow(style.direction);
+    const bool reverse = isReverse(style.direction);
+    const StaticEdge mainLeading = leadingEdge(row, reverse);
+    const StaticEdge mainTrailing = trailingEdge(row, reverse);
+    const StaticEdge crossLeading = leadingEdge(!row, false);
+    const StaticEdge crossTrailing = trailingEdge(!row, false);
+
+    const float mainSize = row ? width : height;
+    const float crossSize = row ? height : width;
+    const float innerMain = mainSize - edgesLength(style.padding, row);
+    const float innerCross = crossSize - edgesLength(style.padding, !row);
+
+    // Flex basis and flexible factors.
+    float consumed = 0;
+    float totalGrow = 0;
+    float totalShrinkScaled = 0;
+    size_t child = index + 1;
+    for (size_t i = 0; i < style.itemCount; i++) {
+        const StaticStyle &childStyle = nodes[child].style;
+        const float basis = contentSize(nodes, count, child, row);
+        frames[child].width = row ? basis : 0;
+        frames[child].height = row ? 0 : basis;
+        consumed += basis + edgesLength(childStyle.margin, row);
+        totalGrow += childStyle.grow;
+        totalShrinkScaled += -childStyle.shrink * basis;
+        child = subtreeEnd(nodes, count, child);
+    }
+    if (totalGrow > 0 && totalGrow < 1) {
+        totalGrow = 1;
+    }
+
+    // Main sizes.
+    const float freeSpace = innerMain - consumed;
+    float remaining = innerMain;
+    child = index + 1;
+    for (size_t i = 0; i < style.itemCount; i++) {
+        const StaticStyle &childStyle = nodes[child].style;
+        float &size = row ? frames[child].width : frames[child].height;
+        if (freeSpace > 0 && totalGrow > 0) {
+            size = size + freeSpace / totalGrow * childStyle.grow;
+        } else if (freeSpace < 0 && totalShrinkScaled < 0) {
+            size = size + freeSpace / totalShrinkScaled * (-childStyle.shrink * size);
+        }
+        size = maximum(size, edgesLength(childStyle.padding, row));
+        remaining -= size + edgesLength(childStyle.margin, row);
+        child = subtreeEnd(nodes, count, child);
+    }
+
+    // Same justification as Yoga.
+    float leading = 0;
+    float between = 0;
+    const float itemCount = static_cast<float>(style.itemCount);
+    switch (style.justifyContent) {
+        case GMFlexJustifyContentCenter:
+            leading = remaining / 2;
+            break;
+        case GMFlexJustifyContentEnd:
+            leading = remaining;
+            break;
+        case GMFlexJustifyContentSpaceBetween:
+            between = style.itemCount > 1 ? maximum(remaining, 0) / (itemCount - 1) : 0;
+            break;
+        case GMFlexJustifyContentSpaceEvenly:
+            between = remaining / (itemCount + 1);
+            leading = between;
+            break;
+        case GMFlexJustifyContentSpaceAround:
+            between = remaining / itemCount;
+            leading = between / 2;
+            break;
+        default:
+            break;
+    }
+
+    float position = style.padding[mainLeading] + leading;
+    child = index + 1;
+    for (size_t i = 0; i < style.itemCount; i++) {
+        const StaticStyle &childStyle = nodes[child].style;
+        StaticFrame &frame = frames[child];
+        const float childMain = row ? frame.width : frame.height;
+
+        // Main axis, from the trailing edge when reversed.
+        float mainPosition = childStyle.margin[mainLeading] + position;
+        if (reverse) {
+            mainPosition = mainSize - childMain - mainPosition;
+        }
+        position += between + (childMain + childStyle.margin[mainLeading] + childStyle.margin[mainTrailing]);
+
+        // Cross axis.
+        const int align = childStyle.alignSelf == GMFlexAlignSelfAuto ? static_cast<int>(style.alignItems) : static_cast<int>(childStyle.alignSelf);
+        const float crossMargins = childStyle.margin[crossLeading] + childStyle.margin[crossTrailing];
+        float childCross = styleSize(childStyle, !row) >= 0 || align != GMFlexAlignItemsStretch
+            ? contentSize(nodes, count, child, !row)
+            : maximum(innerCross - crossMargins, edgesLength(childStyle.padding, !row));
+        const float remainingCross = innerCross - (childCross + childStyle.margin[crossLeading] + childStyle.margin[crossTrailing]);
+        float crossOffset = style.padding[crossLeading];
+        if (align == GMFlexAlignItemsCenter) {
+            crossOffset += remainingCross / 2;
+        } else if (align == GMFlexAlignItemsEnd) {
+            crossOffset += remainingCross;
+        }
+        const float crossPosition = (childStyle.margin[crossLeading] + 0.0f) + crossOffset;
+
+        frame.left = row ? mainPosition : crossPosition;
+        frame.top = row ? crossPosition : mainPosition;
+        if (row) {
+            frame.height = childCross;
+        } else {
+            frame.width = childCross;
+        }
+
+        layoutItems(nodes, count, child, frame.width, frame.height, frames);
+        child = subtreeEnd(nodes, count, child);
+    }
+}
+
+/// Rounds the frames of a subtree to the pixel grid like YGRoundToPixelGrid.
+constexpr void roundToPixelGrid(const StaticNode *nodes, size_t count, size_t index, float scale,
+                                float absoluteLeft, float absoluteTop, StaticFrame *frames)
+{
+    const StaticFrame frame = frames[index];
+    const float absoluteNodeLeft = absoluteLeft + frame.left;
+    const float absoluteNodeTop = absoluteTop + frame.top;
+    const float absoluteNodeRight = absoluteNodeLeft + frame.width;
+    const float absoluteNodeBottom = absoluteNodeTop + frame.height;
+
+    frames[index].left = roundValueToPixelGrid(frame.left, scale);
+    frames[index].top = roundValueToPixelGrid(frame.top, scale);
+    frames[index].width = roundValueToPixelGrid(absoluteNodeRight, scale) - roundValueToPixelGrid(absoluteNodeLeft, scale);
+    frames[index].height = roundValueToPixelGrid(absoluteNodeBottom, scale) - roundValueToPixelGrid(absoluteNodeTop, scale);
+
+    size_t child = index + 1;
+    for (size_t i = 0; i < nodes[index].style.itemCount; i++) {
+        roundToPixelGrid(nodes, count, child, scale, absoluteNodeLeft, absoluteNodeTop, frames);
+        child = subtreeEnd(nodes, count, child);
+    }
+}
+
+} // namespace detail
+
+/**
+ Lays out a static tree in a container of the specified size, like `-[GMFlex layout]`.
+
+ - Parameter nodes: the tree, in depth-first order, the first node being the root.
+ - Parameter width: container width, the root width unless it has its own.
+ - Parameter height: container height, the root height unless it has its own.
+ - Parameter scale: screen scale, 0 not to round frames to the pixel grid.
+ - Returns: the frame of every node, in the same order. The root frame is offset by its margins.
+ */
+template <size_t N>
+constexpr StaticFrameTable<N> solve(const StaticNode (&nodes)[N], float width, float height, float scale)
+{
+    if (detail::subtreeEnd(nodes, N, 0) != N) {
+        detail::invalidStaticTree(); // Nodes not reached from the root.
+    }
+
+    StaticFrameTable<N> table{};
+    const StaticStyle &style = nodes[0].style;
+    StaticFrame &root = table.frames[0];
+    root.left = style.margin[StaticEdgeLeft];
+    root.top = style.margin[StaticEdgeTop];
+    root.width = detail::maximum(style.width >= 0 ? style.width : width - detail::edgesLength(style.margin, true),
+                                 detail::edgesLength(style.padding, true));
+    root.height = detail::maximum(style.height >= 0 ? style.height : height - detail::edgesLength(style.margin, false),
+                                  detail::edgesLength(style.padding, false));
+
+    detail::layoutItems(nodes, N, 0, root.width, root.height, table.frames);
+    if (scale > 0) {
+        detail::roundToPixelGrid(nodes, N, 0, scale, 0, 0, table.frames);
+    }
+    return table;
+}
+
+#ifdef __OBJC__
+template <size_t N>
+struct StaticRectTable {
+    static constexpr NSUInteger count = N;
+    CGRect rects[N];
+};
+
+/**
+ Converts a frame table to the rectangles taken by `-[GMFlex applyFrames:count:]`.
+ */
+template <size_t N>
+constexpr StaticRectTable<N> rects(const StaticFrameTable<N> &table)
+{
+    StaticRectTable<N> rectTable{};
+    for (size_t i = 0; i < N; i++) {
+        const StaticFrame &frame = table.frames[i];
+        rectTable.rects[i] = CGRect{{frame.left, frame.top}, {frame.width, frame.height}};
+    }
+    return rectTable;
+}
+#endif
+
+} // namespace gmflex
+
+#endif /* __cplusplus */
+
+#endif /* GMFlexStaticLayout_h */
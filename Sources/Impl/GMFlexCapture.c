@@ -0,0 +1,258 @@
+//
+//  GMFlexCapture.c
+//  FlexLayout-OC
+//
+
+#include "GMFlexCapture.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+static const char *const GMFlexCaptureEdgeNames[] = {
+    "left", "top", "right", "bottom", "start", "end", "horizontal", "vertical", "all",
+};
+
+typedef struct {
+    float width;
+    YGMeasureMode widthMode;
+    float height;
+    YGMeasureMode heightMode;
+    YGSize size;
+} GMFlexCaptureMeasurement;
+
+typedef struct {
+    YGNodeRef node;
+    YGMeasureFunc measureFunc;
+    GMFlexCaptureMeasurement *measurements;
+    size_t measurementCount;
+    size_t measurementCapacity;
+} GMFlexCaptureLeaf;
+
+struct GMFlexCaptureRecorder {
+    /// Sorted by node address.
+    GMFlexCaptureLeaf *leaves;
+    size_t leafCount;
+    size_t leafCapacity;
+};
+
+/// Measure functions don't get any user data, the wrapper records into the started recorder.
+static GMFlexCaptureRecorderRef GMFlexCaptureStartedRecorder;
+
+static int GMFlexCaptureCompareLeaves(const void *a, const void *b)
+{
+    const uintptr_t nodeA = (uintptr_t)((const GMFlexCaptureLeaf *)a)->node;
+    const uintptr_t nodeB = (uintptr_t)((const GMFlexCaptureLeaf *)b)->node;
+    return nodeA < nodeB ? -1 : nodeA > nodeB;
+}
+
+static GMFlexCaptureLeaf *GMFlexCaptureFindLeaf(GMFlexCaptureRecorderRef recorder, YGNodeRef node)
+{
+    if (recorder == NULL) {
+        return NULL;
+    }
+    const GMFlexCaptureLeaf key = {node, NULL, NULL, 0, 0};
+    return bsearch(&key, recorder->leaves, recorder->leafCount, sizeof(GMFlexCaptureLeaf), GMFlexCaptureCompareLeaves);
+}
+
+static inline bool GMFlexCaptureConstraintEquals(float a, YGMeasureMode aMode, float b, YGMeasureMode bMode)
+{
+    return aMode == bMode && (aMode == YGMeasureModeUndefined || a == b);
+}
+
+static YGSize GMFlexCaptureMeasure(YGNodeRef node, float width, YGMeasureMode widthMode, float height, YGMeasureMode heightMode)
+{
+    GMFlexCaptureLeaf *leaf = GMFlexCaptureFindLeaf(GMFlexCaptureStartedRecorder, node);
+    if (leaf == NULL) {
+        return (YGSize){0, 0};
+    }
+    
+    const YGSize size = leaf->measureFunc(node, width, widthMode, height, heightMode);
+    for (size_t i = 0; i < leaf->measurementCount; i++) {
+        const GMFlexCaptureMeasurement *measurement = &leaf->measurements[i];
+        if (GMFlexCaptureConstraintEquals(measurement->width, measurement->widthMode, width, widthMode) &&
+            GMFlexCaptureConstraintEquals(measurement->height, measurement->heightMode, height, heightMode)) {
+            return size;
+        }
+    }
+    if (leaf->measurementCount == leaf->measurementCapacity) {
+        const size_t capacity = leaf->measurementCapacity == 0 ? 4 : 2 * leaf->measurementCapacity;
+        GMFlexCaptureMeasurement *measurements = realloc(leaf->measurements, capacity * sizeof(GMFlexCaptureMeasurement));
+        if (measurements == NULL) {
+            return size;
+        }
+        leaf->measurements = measurements;
+        leaf->measurementCapacity = capacity;
+    }
+    leaf->measurements[leaf->measurementCount++] = (GMFlexCaptureMeasurement){width, widthMode, height, heightMode, size};
+    return size;
+}
+
+static bool GMFlexCaptureCollectLeaves(GMFlexCaptureRecorderRef recorder, YGNodeRef node)
+{
+    const YGMeasureFunc measureFunc = YGNodeGetMeasureFunc(node);
+    if (measureFunc != NULL) {
+        if (recorder->leafCount == recorder->leafCapacity) {
+            const size_t capacity = recorder->leafCapacity == 0 ? 64 : 2 * recorder->leafCapacity;
+            GMFlexCaptureLeaf *leaves = realloc(recorder->leaves, capacity * sizeof(GMFlexCaptureLeaf));
+            if (leaves == NULL) {
+                return false;
+            }
+            recorder->leaves = leaves;
+            recorder->leafCapacity = capacity;
+        }
+        recorder->leaves[recorder->leafCount++] = (GMFlexCaptureLeaf){node, measureFunc, NULL, 0, 0};
+    }
+    
+    const uint32_t childCount = YGNodeGetChildCount(node);
+    for (uint32_t i = 0; i < childCount; i++) {
+        if (!GMFlexCaptureCollectLeaves(recorder, YGNodeGetChild(node, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+GMFlexCaptureRecorderRef GMFlexCaptureRecorderStart(YGNodeRef root)
+{
+    if (root == NULL || GMFlexCaptureStartedRecorder != NULL) {
+        return NULL;
+    }
+    
+    GMFlexCaptureRecorderRef recorder = calloc(1, sizeof(struct GMFlexCaptureRecorder));
+    if (recorder == NULL) {
+        return NULL;
+    }
+    if (!GMFlexCaptureCollectLeaves(recorder, root)) {
+        free(recorder->leaves);
+        free(recorder);
+        return NULL;
+    }
+    qsort(recorder->leaves, recorder->leafCount, sizeof(GMFlexCaptureLeaf), GMFlexCaptureCompareLeaves);
+    
+    for (size_t i = 0; i < recorder->leafCount; i++) {
+        YGNodeSetMeasureFunc(recorder->leaves[i].node, GMFlexCaptureMeasure);
+        YGNodeMarkDirty(recorder->leaves[i].node);
+    }
+    GMFlexCaptureStartedRecorder = recorder;
+    return recorder;
+}
+
+void GMFlexCaptureRecorderFree(GMFlexCaptureRecorderRef recorder)
+{
+    if (recorder == NULL) {
+        return;
+    }
+    
+    for (size_t i = 0; i < recorder->leafCount; i++) {
+        YGNodeSetMeasureFunc(recorder->leaves[i].node, recorder->leaves[i].measureFunc);
+        free(recorder->leaves[i].measurements);
+    }
+    free(recorder->leaves);
+    if (GMFlexCaptureStartedRecorder == recorder) {
+        GMFlexCaptureStartedRecorder = NULL;
+    }
+    free(recorder);
+}
+
+static void GMFlexCaptureWriteValue(FILE *file, const char *name, YGValue value)
+{
+    switch (value.unit) {
+        case YGUnitPoint:
+            fprintf(file, " %s=%.9g", name, value.value);
+            break;
+        case YGUnitPercent:
+            fprintf(file, " %s=%.9g%%", name, value.value);
+            break;
+        case YGUnitAuto:
+            fprintf(file, " %s=auto", name);
+            break;
+        case YGUnitUndefined:
+            break;
+    }
+}
+
+static void GMFlexCaptureWriteEdgeValue(FILE *file, const char *name, YGEdge edge, YGValue value)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%s.%s", name, GMFlexCaptureEdgeNames[edge]);
+    GMFlexCaptureWriteValue(file, key, value);
+}
+
+static void GMFlexCaptureWriteNode(YGNodeRef node, unsigned depth, GMFlexCaptureGapsFunc gapsFunc, GMFlexCaptureRecorderRef recorder,
+                                   FILE *file)
+{
+    GMFlexCaptureGaps gaps = {0, 0, false, YGEdgeAll, {YGUndefined, YGUnitUndefined}};
+    if (gapsFunc != NULL) {
+        gapsFunc(node, &gaps);
+    }
+    
+    fprintf(file, "node %u", depth);
+    fprintf(file, " direction=%d", YGNodeStyleGetDirection(node));
+    fprintf(file, " flexDirection=%d", YGNodeStyleGetFlexDirection(node));
+    fprintf(file, " justifyContent=%d", YGNodeStyleGetJustifyContent(node));
+    fprintf(file, " alignContent=%d", YGNodeStyleGetAlignContent(node));
+    fprintf(file, " alignItems=%d", YGNodeStyleGetAlignItems(node));
+    fprintf(file, " alignSelf=%d", YGNodeStyleGetAlignSelf(node));
+    fprintf(file, " positionType=%d", YGNodeStyleGetPositionType(node));
+    fprintf(file, " flexWrap=%d", YGNodeStyleGetFlexWrap(node));
+    fprintf(file, " overflow=%d", YGNodeStyleGetOverflow(node));
+    fprintf(file, " display=%d", YGNodeStyleGetDisplay(node));
+    fprintf(file, " flexGrow=%.9g", YGNodeStyleGetFlexGrow(node));
+    fprintf(file, " flexShrink=%.9g", YGNodeStyleGetFlexShrink(node));
+    GMFlexCaptureWriteValue(file, "flexBasis", YGNodeStyleGetFlexBasis(node));
+    GMFlexCaptureWriteValue(file, "width", YGNodeStyleGetWidth(node));
+    GMFlexCaptureWriteValue(file, "height", YGNodeStyleGetHeight(node));
+    GMFlexCaptureWriteValue(file, "minWidth", YGNodeStyleGetMinWidth(node));
+    GMFlexCaptureWriteValue(file, "minHeight", YGNodeStyleGetMinHeight(node));
+    GMFlexCaptureWriteValue(file, "maxWidth", YGNodeStyleGetMaxWidth(node));
+    GMFlexCaptureWriteValue(file, "maxHeight", YGNodeStyleGetMaxHeight(node));
+    if (!YGFloatIsUndefined(YGNodeStyleGetAspectRatio(node))) {
+        fprintf(file, " aspectRatio=%.9g", YGNodeStyleGetAspectRatio(node));
+    }
+    
+    for (int edge = YGEdgeLeft; edge <= YGEdgeAll; edge++) {
+        GMFlexCaptureWriteEdgeValue(file, "position", (YGEdge)edge, YGNodeStyleGetPosition(node, (YGEdge)edge));
+        const bool isGapMargin = gaps.hasGapMargin && gaps.gapMarginEdge == (YGEdge)edge;
+        GMFlexCaptureWriteEdgeValue(file, "margin", (YGEdge)edge, isGapMargin ? gaps.gapMarginOriginal : YGNodeStyleGetMargin(node, (YGEdge)edge));
+        GMFlexCaptureWriteEdgeValue(file, "padding", (YGEdge)edge, YGNodeStyleGetPadding(node, (YGEdge)edge));
+        float border = YGNodeStyleGetBorder(node, (YGEdge)edge);
+        if (!YGFloatIsUndefined(border)) {
+            fprintf(file, " border.%s=%.9g", GMFlexCaptureEdgeNames[edge], border);
+        }
+    }
+    
+    if (gaps.rowGap != 0) {
+        fprintf(file, " rowGap=%.9g", gaps.rowGap);
+    }
+    if (gaps.columnGap != 0) {
+        fprintf(file, " columnGap=%.9g", gaps.columnGap);
+    }
+    
+    const GMFlexCaptureLeaf *leaf = GMFlexCaptureFindLeaf(recorder, node);
+    for (size_t i = 0; leaf != NULL && i < leaf->measurementCount; i++) {
+        const GMFlexCaptureMeasurement *measurement = &leaf->measurements[i];
+        fprintf(file, " measure=%.9g,%d,%.9g,%d,%.9g,%.9g", measurement->width, measurement->widthMode, measurement->height,
+                measurement->heightMode, measurement->size.width, measurement->size.height);
+    }
+    fprintf(file, " frame=%.9g,%.9g,%.9g,%.9g\n",
+            YGNodeLayoutGetLeft(node), YGNodeLayoutGetTop(node), YGNodeLayoutGetWidth(node), YGNodeLayoutGetHeight(node));
+    
+    const uint32_t childCount = YGNodeGetChildCount(node);
+    for (uint32_t i = 0; i < childCount; i++) {
+        GMFlexCaptureWriteNode(YGNodeGetChild(node, i), depth + 1, gapsFunc, recorder, file);
+    }
+}
+
+bool GMFlexCaptureWrite(YGNodeRef root, int layoutMode, float width, float height, const GMFlexCaptureConfig *config,
+                        GMFlexCaptureGapsFunc gaps, GMFlexCaptureRecorderRef recorder, FILE *file)
+{
+    if (root == NULL || config == NULL || file == NULL) {
+        return false;
+    }
+    
+    fprintf(file, "gmflex-capture %d\n", GMFLEX_CAPTURE_VERSION);
+    fprintf(file, "layout mode=%d width=%.9g height=%.9g\n", layoutMode, width, height);
+    fprintf(file, "config scale=%.9g experimentalFeatures=%u useWebDefaults=%d useLegacyStretchBehaviour=%d\n",
+            config->pointScaleFactor, config->experimentalFeatures, config->useWebDefaults, config->useLegacyStretchBehaviour);
+    GMFlexCaptureWriteNode(root, 0, gaps, recorder, file);
+    return ferror(file) == 0;
+}
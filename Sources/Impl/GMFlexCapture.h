@@ -0,0 +1,104 @@
+//
+//  GMFlexCapture.h
+//  FlexLayout-OC
+//
+//  Writes a Yoga node tree, its styles and measurement results to a portable text file that
+//  Tools/FlexReplay can load to solve the same layout offline.
+//
+
+#ifndef GMFlexCapture_h
+#define GMFlexCapture_h
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <yoga/Yoga.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Version written on the first line of a capture, incremented on incompatible format changes.
+#define GMFLEX_CAPTURE_VERSION 4
+
+/**
+ Yoga configuration of the captured tree, which changes how it is solved. Yoga doesn't give a node's configuration
+ back, so it is described by the caller. Yoga 1.9 has no errata, its legacy stretch behaviour is the compatibility
+ switch playing that part.
+ */
+typedef struct {
+    float pointScaleFactor;
+    /// `1 << feature` for each enabled YGExperimentalFeature.
+    uint32_t experimentalFeatures;
+    bool useWebDefaults;
+    bool useLegacyStretchBehaviour;
+} GMFlexCaptureConfig;
+
+/**
+ Gaps of a node, which FlexLayout keeps outside of the Yoga style.
+ */
+typedef struct {
+    float rowGap;
+    float columnGap;
+    /// Whether a margin of the node holds the gap of its container.
+    bool hasGapMargin;
+    /// Margin edge holding that gap.
+    YGEdge gapMarginEdge;
+    /// Style value of that edge without the gap.
+    YGValue gapMarginOriginal;
+} GMFlexCaptureGaps;
+
+/// Returns the gaps of a node.
+typedef void (*GMFlexCaptureGapsFunc)(YGNodeRef node, GMFlexCaptureGaps *gaps);
+
+/// Records the measure function calls of the leaves of a tree, see GMFlexCaptureRecorderStart.
+typedef struct GMFlexCaptureRecorder *GMFlexCaptureRecorderRef;
+
+/**
+ Starts recording the measure function calls of the leaves of a tree: their measure functions are wrapped, and they
+ are marked dirty so that the next calculation of the tree measures them again. One recorder at most can be started
+ at a time.
+ 
+ - Returns: NULL if memory couldn't be allocated.
+ */
+GMFlexCaptureRecorderRef GMFlexCaptureRecorderStart(YGNodeRef root);
+
+/**
+ Restores the measure functions of the leaves and frees the recorder.
+ */
+void GMFlexCaptureRecorderFree(GMFlexCaptureRecorderRef recorder);
+
+/**
+ Writes the capture of a laid out Yoga tree.
+ 
+ Format, one record per line:
+ ```
+ gmflex-capture <version>
+ layout mode=<GMFlexLayoutMode> width=<float> height=<float>
+ config scale=<float> experimentalFeatures=<mask> useWebDefaults=<0|1> useLegacyStretchBehaviour=<0|1>
+ node <depth> <property>=<value> ...
+ ```
+ Nodes are written depth-first, `depth` is 0 for the root. Float values use `%.9g`, lengths are either a number of
+ points, a percentage (`50%`) or `auto`, undefined properties are omitted. Edge properties are named
+ `<property>.<edge>`, for example `margin.left`. Containers having gaps get `rowGap` and `columnGap` properties, and
+ the margins of their items are written without the gaps, which the replay adds again the same way. Leaves with a
+ measure function get a `measure=<width>,<widthMode>,<height>,<heightMode>,<measuredWidth>,<measuredHeight>`
+ property for each distinct call recorded, and every node gets its solved `frame=<left>,<top>,<width>,<height>`.
+ 
+ - Parameter root: root node, laid out with the constraints below.
+ - Parameter layoutMode: the `GMFlexLayoutMode` used.
+ - Parameter width: width constraint, `YGUndefined` if the width is adjusted to the content.
+ - Parameter height: height constraint, `YGUndefined` if the height is adjusted to the content.
+ - Parameter config: Yoga configuration of the tree.
+ - Parameter gaps: returns the gaps of each node, NULL if the tree has none.
+ - Parameter recorder: measure function calls of the calculation, NULL to write none.
+ - Returns: false if writing failed.
+ */
+bool GMFlexCaptureWrite(YGNodeRef root, int layoutMode, float width, float height, const GMFlexCaptureConfig *config,
+                        GMFlexCaptureGapsFunc gaps, GMFlexCaptureRecorderRef recorder, FILE *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GMFlexCapture_h */
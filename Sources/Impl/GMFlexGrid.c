@@ -0,0 +1,297 @@
+//
+//  GMFlexGrid.c
+//  FlexLayout-OC
+//
+
+#include "GMFlexGrid.h"
+#include "GMFlexStyle.h"
+#include <math.h>
+
+/// Lengths are computed in 1/64 point units, exactly representable by floats below 2^24 units.
+#define GMFLEX_GRID_UNITS 64
+#define GMFLEX_GRID_MAX_UNITS (1 << 24)
+
+static inline bool GMFlexGridFloatsEqual(float a, float b)
+{
+    return fabsf(a - b) < 0.0001f;
+}
+
+/**
+ Same as Yoga's YGRoundValueToPixelGrid, without text rounding.
+ */
+static float GMFlexGridRoundValueToPixelGrid(float value, float scale)
+{
+    float scaledValue = value * scale;
+    float fractial = fmodf(scaledValue, 1.0f);
+    if (GMFlexGridFloatsEqual(fractial, 0)) {
+        scaledValue = scaledValue - fractial;
+    } else if (GMFlexGridFloatsEqual(fractial, 1.0f)) {
+        scaledValue = scaledValue - fractial + 1.0f;
+    } else {
+        scaledValue = scaledValue - fractial + (fractial > 0.5f || GMFlexGridFloatsEqual(fractial, 0.5f) ? 1.0f : 0.0f);
+    }
+    return scaledValue / scale;
+}
+
+/**
+ Converts a length to 1/64 point units. Returns false if it isn't a multiple of 1/64 point or is too large.
+ */
+static bool GMFlexGridUnits(float value, long *units)
+{
+    const float scaled = value * GMFLEX_GRID_UNITS;
+    if (!(fabsf(scaled) < GMFLEX_GRID_MAX_UNITS) || scaled != floorf(scaled)) {
+        return false;
+    }
+    *units = (long)scaled;
+    return true;
+}
+
+typedef struct {
+    // Values indexed by YGEdge, `defined` tells which edges are set.
+    float values[YGEdgeAll + 1];
+    bool defined[YGEdgeAll + 1];
+} GMFlexGridEdges;
+
+/**
+ Resolves a physical edge (left, top, right, bottom) of LTR margins or paddings the way Yoga does:
+ start/end first for horizontal edges, then the edge itself, then horizontal/vertical, then all.
+ */
+static float GMFlexGridResolveEdge(const GMFlexGridEdges *edges, YGEdge edge)
+{
+    if (edge == YGEdgeLeft && edges->defined[YGEdgeStart]) {
+        return edges->values[YGEdgeStart];
+    }
+    if (edge == YGEdgeRight && edges->defined[YGEdgeEnd]) {
+        return edges->values[YGEdgeEnd];
+    }
+    if (edges->defined[edge]) {
+        return edges->values[edge];
+    }
+    if ((edge == YGEdgeLeft || edge == YGEdgeRight) && edges->defined[YGEdgeHorizontal]) {
+        return edges->values[YGEdgeHorizontal];
+    }
+    if ((edge == YGEdgeTop || edge == YGEdgeBottom) && edges->defined[YGEdgeVertical]) {
+        return edges->values[YGEdgeVertical];
+    }
+    return edges->defined[YGEdgeAll] ? edges->values[YGEdgeAll] : 0;
+}
+
+static bool GMFlexGridEntriesEqual(const GMFlexStyleEntry *a, const GMFlexStyleEntry *b, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (a[i].property != b[i].property || a[i].edge != b[i].edge || a[i].unit != b[i].unit || a[i].value != b[i].value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GMFlexGridLayout(YGNodeRef container, const YGNodeRef *children, size_t count, float width, float height, float scale,
+                      GMFlexGridFrame *frames, GMFlexGridLayoutResult *result)
+{
+    if (count == 0 || scale <= 0) {
+        return false;
+    }
+    
+    // Container style.
+    GMFlexStyleEntry entries[GMFLEX_STYLE_MAX_ENTRIES];
+    size_t entryCount = GMFlexStyleRecord(container, entries);
+    bool isRow = false;
+    bool isWrapping = false;
+    YGAlign alignItems = YGAlignStretch;
+    YGAlign alignContent = YGAlignFlexStart;
+    GMFlexGridEdges padding = {{0}, {false}};
+    for (size_t i = 0; i < entryCount; i++) {
+        const GMFlexStyleEntry entry = entries[i];
+        switch ((GMFlexStyleProperty)entry.property) {
+            case GMFlexStylePropertyDirection:
+                if ((YGDirection)entry.value == YGDirectionRTL) {
+                    return false;
+                }
+                break;
+            case GMFlexStylePropertyFlexDirection:
+                if ((YGFlexDirection)entry.value != YGFlexDirectionRow) {
+                    return false;
+                }
+                isRow = true;
+                break;
+            case GMFlexStylePropertyFlexWrap:
+                isWrapping = (YGWrap)entry.value == YGWrapWrap;
+                break;
+            case GMFlexStylePropertyAlignItems:
+                alignItems = (YGAlign)entry.value;
+                break;
+            case GMFlexStylePropertyAlignContent:
+                alignContent = (YGAlign)entry.value;
+                break;
+            case GMFlexStylePropertyOverflow:
+                break;
+            case GMFlexStylePropertyPadding:
+                if (entry.unit != YGUnitPoint) {
+                    return false;
+                }
+                padding.values[entry.edge] = fmaxf(entry.value, 0);
+                padding.defined[entry.edge] = true;
+                break;
+            default:
+                return false;
+        }
+    }
+    if (!isWrapping) {
+        return false;
+    }
+    
+    // Children style, identical for all of them.
+    GMFlexStyleEntry childEntries[GMFLEX_STYLE_MAX_ENTRIES];
+    const size_t childEntryCount = GMFlexStyleRecord(children[0], childEntries);
+    for (size_t i = 1; i < count; i++) {
+        if (GMFlexStyleRecord(children[i], entries) != childEntryCount || !GMFlexGridEntriesEqual(entries, childEntries, childEntryCount)) {
+            return false;
+        }
+    }
+    
+    float childWidth = NAN;
+    float childHeight = NAN;
+    float flexShrink = 0;
+    YGAlign align = alignItems;
+    GMFlexGridEdges margin = {{0}, {false}};
+    for (size_t i = 0; i < childEntryCount; i++) {
+        const GMFlexStyleEntry entry = childEntries[i];
+        switch ((GMFlexStyleProperty)entry.property) {
+            case GMFlexStylePropertyWidth:
+                childWidth = entry.unit == YGUnitPoint ? entry.value : NAN;
+                break;
+            case GMFlexStylePropertyHeight:
+                childHeight = entry.unit == YGUnitPoint ? entry.value : NAN;
+                break;
+            case GMFlexStylePropertyMargin:
+                if (entry.unit != YGUnitPoint) {
+                    return false;
+                }
+                margin.values[entry.edge] = entry.value;
+                margin.defined[entry.edge] = true;
+                break;
+            case GMFlexStylePropertyAlignSelf:
+                align = (YGAlign)entry.value;
+                break;
+            case GMFlexStylePropertyFlexShrink:
+                flexShrink = entry.value;
+                break;
+            case GMFlexStylePropertyOverflow:
+                break;
+            default:
+                return false;
+        }
+    }
+    if (align == YGAlignAuto) {
+        align = alignItems;
+    }
+    if (isnan(childWidth) || isnan(childHeight) || childWidth < 0 || childHeight < 0 || align == YGAlignBaseline ||
+        align == YGAlignSpaceBetween || align == YGAlignSpaceAround) {
+        return false;
+    }
+    
+    // Everything below is computed in exact 1/64 point units, main and cross axes.
+    long paddingLeft, paddingTop, paddingRight, paddingBottom;
+    long marginLeft, marginTop, marginRight, marginBottom;
+    long sizeWidth, sizeHeight;
+    if (!GMFlexGridUnits(GMFlexGridResolveEdge(&padding, YGEdgeLeft), &paddingLeft) ||
+        !GMFlexGridUnits(GMFlexGridResolveEdge(&padding, YGEdgeTop), &paddingTop) ||
+        !GMFlexGridUnits(GMFlexGridResolveEdge(&padding, YGEdgeRight), &paddingRight) ||
+        !GMFlexGridUnits(GMFlexGridResolveEdge(&padding, YGEdgeBottom), &paddingBottom) ||
+        !GMFlexGridUnits(GMFlexGridResolveEdge(&margin, YGEdgeLeft), &marginLeft) ||
+        !GMFlexGridUnits(GMFlexGridResolveEdge(&margin, YGEdgeTop), &marginTop) ||
+        !GMFlexGridUnits(GMFlexGridResolveEdge(&margin, YGEdgeRight), &marginRight) ||
+        !GMFlexGridUnits(GMFlexGridResolveEdge(&margin, YGEdgeBottom), &marginBottom) ||
+        !GMFlexGridUnits(childWidth, &sizeWidth) ||
+        !GMFlexGridUnits(childHeight, &sizeHeight)) {
+        return false;
+    }
+    
+    const bool isMainDefined = !isnan(isRow ? width : height);
+    const bool isCrossDefined = !isnan(isRow ? height : width);
+    long mainSize = 0, crossSize = 0;
+    if ((isMainDefined && !GMFlexGridUnits(isRow ? width : height, &mainSize)) ||
+        (isCrossDefined && !GMFlexGridUnits(isRow ? height : width, &crossSize))) {
+        return false;
+    }
+    
+    const long paddingMainLeading = isRow ? paddingLeft : paddingTop;
+    const long paddingMainTrailing = isRow ? paddingRight : paddingBottom;
+    const long paddingCrossLeading = isRow ? paddingTop : paddingLeft;
+    const long paddingCrossTrailing = isRow ? paddingBottom : paddingRight;
+    const long marginMainLeading = isRow ? marginLeft : marginTop;
+    const long marginCrossLeading = isRow ? marginTop : marginLeft;
+    const long childMain = isRow ? sizeWidth : sizeHeight;
+    const long childCross = isRow ? sizeHeight : sizeWidth;
+    const long outerMain = childMain + (isRow ? marginLeft + marginRight : marginTop + marginBottom);
+    const long outerCross = childCross + (isRow ? marginTop + marginBottom : marginLeft + marginRight);
+    const long innerMain = mainSize - paddingMainLeading - paddingMainTrailing;
+    const long innerCross = crossSize - paddingCrossLeading - paddingCrossTrailing;
+    
+    // Yoga starts a new line when an item doesn't fit the available main size, unless it's alone on its line.
+    size_t itemsPerLine = count;
+    if (isMainDefined && outerMain > 0) {
+        itemsPerLine = innerMain >= outerMain ? (size_t)(innerMain / outerMain) : 1;
+        if (itemsPerLine > count) {
+            itemsPerLine = count;
+        }
+    }
+    if (isMainDefined && outerMain > innerMain && flexShrink > 0) {
+        return false;
+    }
+    const size_t lineCount = (count + itemsPerLine - 1) / itemsPerLine;
+    if (isCrossDefined && lineCount > 1 && alignContent != YGAlignFlexStart) {
+        return false;
+    }
+    
+    // Offset of a child in its line, from the line cross start to the child cross start, in 1/128 point units since
+    // centering halves lengths.
+    long crossOffset2;
+    if (isCrossDefined && lineCount > 1) {
+        // Multi-line content alignment.
+        crossOffset2 = align == YGAlignCenter ? outerCross - childCross : 2 * marginCrossLeading;
+    } else {
+        // Cross-axis alignment within the container: the line fills it when its cross size is defined.
+        const long remaining = isCrossDefined && lineCount == 1 ? innerCross - outerCross : 0;
+        crossOffset2 = 2 * marginCrossLeading + (align == YGAlignFlexEnd ? 2 * remaining : align == YGAlignCenter ? remaining : 0);
+    }
+    
+    const long contentMain = (long)itemsPerLine * outerMain;
+    const long contentCross = (long)lineCount * outerCross;
+    const long containerMain = isMainDefined ? mainSize : paddingMainLeading + contentMain + paddingMainTrailing;
+    const long containerCross = isCrossDefined ? crossSize : paddingCrossLeading + contentCross + paddingCrossTrailing;
+    if (containerMain >= GMFLEX_GRID_MAX_UNITS || containerCross >= GMFLEX_GRID_MAX_UNITS) {
+        return false;
+    }
+    
+    // Yoga rounds absolute positions, which are relative positions for the children of a root. A child solved on its
+    // own, as a root, is placed at its leading margins, which must be on the pixel grid too.
+    const float childMarginLeft = (float)marginLeft / GMFLEX_GRID_UNITS;
+    const float childMarginTop = (float)marginTop / GMFLEX_GRID_UNITS;
+    bool isOnPixelGrid = GMFlexGridRoundValueToPixelGrid(childMarginLeft, scale) == childMarginLeft &&
+                         GMFlexGridRoundValueToPixelGrid(childMarginTop, scale) == childMarginTop;
+    for (size_t i = 0; i < count; i++) {
+        const long line = (long)(i / itemsPerLine);
+        const long column = (long)(i % itemsPerLine);
+        const float main = (float)(paddingMainLeading + column * outerMain + marginMainLeading) / GMFLEX_GRID_UNITS;
+        const float cross = (float)(2 * (paddingCrossLeading + line * outerCross) + crossOffset2) / (2 * GMFLEX_GRID_UNITS);
+        const float left = isRow ? main : cross;
+        const float top = isRow ? cross : main;
+        
+        GMFlexGridFrame frame;
+        frame.left = GMFlexGridRoundValueToPixelGrid(left, scale);
+        frame.top = GMFlexGridRoundValueToPixelGrid(top, scale);
+        frame.width = GMFlexGridRoundValueToPixelGrid(left + childWidth, scale) - frame.left;
+        frame.height = GMFlexGridRoundValueToPixelGrid(top + childHeight, scale) - frame.top;
+        isOnPixelGrid = isOnPixelGrid && frame.left == left && frame.top == top && frame.width == childWidth && frame.height == childHeight;
+        frames[i] = frame;
+    }
+    
+    const float containerWidth = (float)(isRow ? containerMain : containerCross) / GMFLEX_GRID_UNITS;
+    const float containerHeight = (float)(isRow ? containerCross : containerMain) / GMFLEX_GRID_UNITS;
+    result->width = GMFlexGridRoundValueToPixelGrid(containerWidth, scale);
+    result->height = GMFlexGridRoundValueToPixelGrid(containerHeight, scale);
+    result->isOnPixelGrid = isOnPixelGrid;
+    return true;
+}
@@ -0,0 +1,59 @@
+//
+//  GMFlexGrid.h
+//  FlexLayout-OC
+//
+//  Closed-form layout of wrapping containers whose children all share the same fixed size style, such as photo
+//  grids. Produces the same frames as Yoga, including its pixel grid rounding, in O(n) without laying out children.
+//
+
+#ifndef GMFlexGrid_h
+#define GMFlexGrid_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <yoga/Yoga.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    float left;
+    float top;
+    float width;
+    float height;
+} GMFlexGridFrame;
+
+typedef struct {
+    /// Container size, rounded to the pixel grid.
+    float width;
+    float height;
+    /// True if no frame was changed by the pixel grid rounding and the leading margins of the children are on the
+    /// pixel grid, which makes each child subtree layout independent of its position: solving a child as a root, at
+    /// its margins, rounds its subtree like the whole tree does.
+    bool isOnPixelGrid;
+} GMFlexGridLayoutResult;
+
+/**
+ Lays out the children of a wrapping root container in closed form, if the container and its children are eligible:
+ 
+ - The container is a row or a column, wrapping, LTR, with flex-start justification and only point paddings.
+ - The children have exactly the same style: a point width and height, point margins and nothing else but alignSelf.
+ - Every length is a multiple of 1/64 point, so that float sums are exact whatever their order.
+ 
+ - Parameter container: root node, its children nodes don't need to be attached.
+ - Parameter children: the nodes of the included children, in order.
+ - Parameter width: container width, `YGUndefined` if adjusted to the content.
+ - Parameter height: container height, `YGUndefined` if adjusted to the content.
+ - Parameter scale: point scale factor of the Yoga configuration.
+ - Parameter frames: receives the children frames, relative to the container, `count` long.
+ - Returns: false if the container isn't eligible, in which case it must be laid out by Yoga.
+ */
+bool GMFlexGridLayout(YGNodeRef container, const YGNodeRef *children, size_t count, float width, float height, float scale,
+                      GMFlexGridFrame *frames, GMFlexGridLayoutResult *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GMFlexGrid_h */
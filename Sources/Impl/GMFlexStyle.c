@@ -0,0 +1,110 @@
+//
+//  GMFlexStyle.c
+//  FlexLayout-OC
+//
+
+#include "GMFlexStyle.h"
+#include <pthread.h>
+
+static YGNodeRef GMFlexStyleDefaultNode = NULL;
+static pthread_once_t GMFlexStyleDefaultNodeOnce = PTHREAD_ONCE_INIT;
+
+static void GMFlexStyleCreateDefaultNode(void)
+{
+    GMFlexStyleDefaultNode = YGNodeNew();
+}
+
+static inline int GMFlexStyleFloatsEqual(float a, float b)
+{
+    return a == b || (YGFloatIsUndefined(a) && YGFloatIsUndefined(b));
+}
+
+static inline int GMFlexStyleValuesEqual(YGValue a, YGValue b)
+{
+    return a.unit == b.unit && (a.unit == YGUnitUndefined || a.unit == YGUnitAuto || GMFlexStyleFloatsEqual(a.value, b.value));
+}
+
+static inline void GMFlexStyleAppend(GMFlexStyleEntry *entries, size_t *count, GMFlexStyleProperty property, YGEdge edge, YGUnit unit, float value)
+{
+    GMFlexStyleEntry entry = { (uint8_t)property, (uint8_t)edge, (uint8_t)unit, value };
+    entries[(*count)++] = entry;
+}
+
+#define GMFLEX_STYLE_RECORD_ENUM(property, getter) \
+    if (getter(node) != getter(defaultNode)) { \
+        GMFlexStyleAppend(entries, &count, property, YGEdgeAll, YGUnitUndefined, (float)getter(node)); \
+    }
+
+#define GMFLEX_STYLE_RECORD_FLOAT(property, getter) \
+    if (!GMFlexStyleFloatsEqual(getter(node), getter(defaultNode))) { \
+        GMFlexStyleAppend(entries, &count, property, YGEdgeAll, YGUnitPoint, getter(node)); \
+    }
+
+#define GMFLEX_STYLE_RECORD_VALUE(property, getter) \
+    if (!GMFlexStyleValuesEqual(getter(node), getter(defaultNode))) { \
+        YGValue value = getter(node); \
+        GMFlexStyleAppend(entries, &count, property, YGEdgeAll, value.unit, value.value); \
+    }
+
+#define GMFLEX_STYLE_RECORD_EDGE_VALUE(property, getter, edge) \
+    if (!GMFlexStyleValuesEqual(getter(node, edge), getter(defaultNode, edge))) { \
+        YGValue value = getter(node, edge); \
+        GMFlexStyleAppend(entries, &count, property, edge, value.unit, value.value); \
+    }
+
+size_t GMFlexStyleRecord(YGNodeRef node, GMFlexStyleEntry *entries)
+{
+    pthread_once(&GMFlexStyleDefaultNodeOnce, GMFlexStyleCreateDefaultNode);
+    const YGNodeRef defaultNode = GMFlexStyleDefaultNode;
+    size_t count = 0;
+    
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyDirection, YGNodeStyleGetDirection)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyFlexDirection, YGNodeStyleGetFlexDirection)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyJustifyContent, YGNodeStyleGetJustifyContent)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyAlignContent, YGNodeStyleGetAlignContent)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyAlignItems, YGNodeStyleGetAlignItems)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyAlignSelf, YGNodeStyleGetAlignSelf)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyPositionType, YGNodeStyleGetPositionType)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyFlexWrap, YGNodeStyleGetFlexWrap)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyOverflow, YGNodeStyleGetOverflow)
+    GMFLEX_STYLE_RECORD_ENUM(GMFlexStylePropertyDisplay, YGNodeStyleGetDisplay)
+    GMFLEX_STYLE_RECORD_FLOAT(GMFlexStylePropertyFlexGrow, YGNodeStyleGetFlexGrow)
+    GMFLEX_STYLE_RECORD_FLOAT(GMFlexStylePropertyFlexShrink, YGNodeStyleGetFlexShrink)
+    GMFLEX_STYLE_RECORD_FLOAT(GMFlexStylePropertyAspectRatio, YGNodeStyleGetAspectRatio)
+    GMFLEX_STYLE_RECORD_VALUE(GMFlexStylePropertyFlexBasis, YGNodeStyleGetFlexBasis)
+    GMFLEX_STYLE_RECORD_VALUE(GMFlexStylePropertyWidth, YGNodeStyleGetWidth)
+    GMFLEX_STYLE_RECORD_VALUE(GMFlexStylePropertyHeight, YGNodeStyleGetHeight)
+    GMFLEX_STYLE_RECORD_VALUE(GMFlexStylePropertyMinWidth, YGNodeStyleGetMinWidth)
+    GMFLEX_STYLE_RECORD_VALUE(GMFlexStylePropertyMinHeight, YGNodeStyleGetMinHeight)
+    GMFLEX_STYLE_RECORD_VALUE(GMFlexStylePropertyMaxWidth, YGNodeStyleGetMaxWidth)
+    GMFLEX_STYLE_RECORD_VALUE(GMFlexStylePropertyMaxHeight, YGNodeStyleGetMaxHeight)
+    
+    for (int i = YGEdgeLeft; i <= YGEdgeAll; i++) {
+        const YGEdge edge = (YGEdge)i;
+        GMFLEX_STYLE_RECORD_EDGE_VALUE(GMFlexStylePropertyPosition, YGNodeStyleGetPosition, edge)
+        GMFLEX_STYLE_RECORD_EDGE_VALUE(GMFlexStylePropertyMargin, YGNodeStyleGetMargin, edge)
+        GMFLEX_STYLE_RECORD_EDGE_VALUE(GMFlexStylePropertyPadding, YGNodeStyleGetPadding, edge)
+        if (!GMFlexStyleFloatsEqual(YGNodeStyleGetBorder(node, edge), YGNodeStyleGetBorder(defaultNode, edge))) {
+            GMFlexStyleAppend(entries, &count, GMFlexStylePropertyBorder, edge, YGUnitPoint, YGNodeStyleGetBorder(node, edge));
+        }
+    }
+    
+    return count;
+}
+
+bool GMFlexStyleEqual(YGNodeRef node, YGNodeRef otherNode)
+{
+    GMFlexStyleEntry entries[GMFLEX_STYLE_MAX_ENTRIES];
+    GMFlexStyleEntry otherEntries[GMFLEX_STYLE_MAX_ENTRIES];
+    const size_t count = GMFlexStyleRecord(node, entries);
+    if (GMFlexStyleRecord(otherNode, otherEntries) != count) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].property != otherEntries[i].property || entries[i].edge != otherEntries[i].edge ||
+            entries[i].unit != otherEntries[i].unit || !GMFlexStyleFloatsEqual(entries[i].value, otherEntries[i].value)) {
+            return false;
+        }
+    }
+    return true;
+}
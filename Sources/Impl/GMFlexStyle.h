@@ -0,0 +1,75 @@
+//
+//  GMFlexStyle.h
+//  FlexLayout-OC
+//
+//  Compact record of the style of a Yoga node: only the properties that differ from Yoga defaults are kept.
+//
+
+#ifndef GMFlexStyle_h
+#define GMFlexStyle_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <yoga/Yoga.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GMFlexStylePropertyDirection = 0,
+    GMFlexStylePropertyFlexDirection,
+    GMFlexStylePropertyJustifyContent,
+    GMFlexStylePropertyAlignContent,
+    GMFlexStylePropertyAlignItems,
+    GMFlexStylePropertyAlignSelf,
+    GMFlexStylePropertyPositionType,
+    GMFlexStylePropertyFlexWrap,
+    GMFlexStylePropertyOverflow,
+    GMFlexStylePropertyDisplay,
+    GMFlexStylePropertyFlexGrow,
+    GMFlexStylePropertyFlexShrink,
+    GMFlexStylePropertyAspectRatio,
+    GMFlexStylePropertyFlexBasis,
+    GMFlexStylePropertyWidth,
+    GMFlexStylePropertyHeight,
+    GMFlexStylePropertyMinWidth,
+    GMFlexStylePropertyMinHeight,
+    GMFlexStylePropertyMaxWidth,
+    GMFlexStylePropertyMaxHeight,
+    // Edge properties, one entry per edge.
+    GMFlexStylePropertyPosition,
+    GMFlexStylePropertyMargin,
+    GMFlexStylePropertyPadding,
+    GMFlexStylePropertyBorder,
+} GMFlexStyleProperty;
+
+typedef struct {
+    uint8_t property; // GMFlexStyleProperty
+    uint8_t edge; // YGEdge, for edge properties
+    uint8_t unit; // YGUnit, for lengths
+    float value; // Enum value, number or length
+} GMFlexStyleEntry;
+
+/// Maximum number of entries of a node record.
+#define GMFLEX_STYLE_MAX_ENTRIES 64
+
+/**
+ Records the style properties of `node` that differ from a new node.
+ 
+ - Parameter entries: receives the record, at least `GMFLEX_STYLE_MAX_ENTRIES` long.
+ - Returns: the number of entries written.
+ */
+size_t GMFlexStyleRecord(YGNodeRef node, GMFlexStyleEntry *entries);
+
+/**
+ Returns whether two nodes have the same style, the test YGNodeCopyStyle does before copying.
+ */
+bool GMFlexStyleEqual(YGNodeRef node, YGNodeRef otherNode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GMFlexStyle_h */
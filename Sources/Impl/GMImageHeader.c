@@ -0,0 +1,271 @@
+//
+//  GMImageHeader.c
+//  FlexLayout-OC
+//
+
+#include "GMImageHeader.h"
+#include <string.h>
+
+static inline uint32_t GMReadBE16(const uint8_t *p) { return ((uint32_t)p[0] << 8) | p[1]; }
+static inline uint32_t GMReadBE32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]; }
+static inline uint32_t GMReadLE16(const uint8_t *p) { return ((uint32_t)p[1] << 8) | p[0]; }
+static inline uint32_t GMReadLE24(const uint8_t *p) { return ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0]; }
+static inline uint32_t GMReadLE32(const uint8_t *p) { return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0]; }
+
+static inline uint32_t GMReadTIFF16(const uint8_t *p, int littleEndian) { return littleEndian ? GMReadLE16(p) : GMReadBE16(p); }
+static inline uint32_t GMReadTIFF32(const uint8_t *p, int littleEndian) { return littleEndian ? GMReadLE32(p) : GMReadBE32(p); }
+
+/**
+ Compares the prefix available in `bytes` with `signature`.
+ */
+static GMImageHeaderStatus GMMatchSignature(const uint8_t *bytes, size_t length, const char *signature, size_t signatureLength)
+{
+    size_t count = length < signatureLength ? length : signatureLength;
+    if (memcmp(bytes, signature, count) != 0) {
+        return GMImageHeaderStatusInvalid;
+    }
+    return count == signatureLength ? GMImageHeaderStatusOK : GMImageHeaderStatusNeedMoreData;
+}
+
+static GMImageHeaderStatus GMParsePNG(const uint8_t *bytes, size_t length, GMImageHeaderInfo *info)
+{
+    // Signature, then the IHDR chunk which must come first: length, type, width, height. PNGs crushed by Xcode for the
+    // app bundle start with a CgBI chunk instead, followed by IHDR.
+    size_t offset = 8;
+    if (length < offset + 8) {
+        return GMImageHeaderStatusNeedMoreData;
+    }
+    if (memcmp(bytes + offset + 4, "CgBI", 4) == 0) {
+        const uint32_t chunkLength = GMReadBE32(bytes + offset);
+        if (chunkLength > 0x7fffffff) {
+            return GMImageHeaderStatusInvalid;
+        }
+        // Length, type, data and CRC.
+        offset += 12 + (size_t)chunkLength;
+    }
+    
+    if (length < offset + 16) {
+        return GMImageHeaderStatusNeedMoreData;
+    }
+    if (memcmp(bytes + offset + 4, "IHDR", 4) != 0) {
+        return GMImageHeaderStatusInvalid;
+    }
+    info->width = GMReadBE32(bytes + offset + 8);
+    info->height = GMReadBE32(bytes + offset + 12);
+    return GMImageHeaderStatusOK;
+}
+
+static GMImageHeaderStatus GMParseGIF(const uint8_t *bytes, size_t length, GMImageHeaderInfo *info)
+{
+    // "GIF87a" or "GIF89a", then the logical screen width and height.
+    if (length < 10) {
+        return GMImageHeaderStatusNeedMoreData;
+    }
+    if (bytes[4] != '7' && bytes[4] != '9') {
+        return GMImageHeaderStatusInvalid;
+    }
+    info->width = GMReadLE16(bytes + 6);
+    info->height = GMReadLE16(bytes + 8);
+    return GMImageHeaderStatusOK;
+}
+
+static GMImageHeaderStatus GMParseWebP(const uint8_t *bytes, size_t length, GMImageHeaderInfo *info)
+{
+    // "RIFF", file size, "WEBP", then the first chunk fourcc and size. Its payload starts at offset 20.
+    if (length < 16) {
+        return GMImageHeaderStatusNeedMoreData;
+    }
+    const uint8_t *chunk = bytes + 12;
+    if (memcmp(chunk, "VP8 ", 4) == 0) {
+        // Lossy: 3 bytes frame tag, 3 bytes start code, then 14 bits width and height.
+        if (length < 30) {
+            return GMImageHeaderStatusNeedMoreData;
+        }
+        if (bytes[23] != 0x9d || bytes[24] != 0x01 || bytes[25] != 0x2a) {
+            return GMImageHeaderStatusInvalid;
+        }
+        info->width = GMReadLE16(bytes + 26) & 0x3fff;
+        info->height = GMReadLE16(bytes + 28) & 0x3fff;
+    } else if (memcmp(chunk, "VP8L", 4) == 0) {
+        // Lossless: signature byte, then 14 bits width - 1 and 14 bits height - 1.
+        if (length < 25) {
+            return GMImageHeaderStatusNeedMoreData;
+        }
+        if (bytes[20] != 0x2f) {
+            return GMImageHeaderStatusInvalid;
+        }
+        uint32_t bits = GMReadLE32(bytes + 21);
+        info->width = (bits & 0x3fff) + 1;
+        info->height = ((bits >> 14) & 0x3fff) + 1;
+    } else if (memcmp(chunk, "VP8X", 4) == 0) {
+        // Extended: flags, 3 reserved bytes, then 24 bits canvas width - 1 and height - 1.
+        if (length < 30) {
+            return GMImageHeaderStatusNeedMoreData;
+        }
+        info->width = GMReadLE24(bytes + 24) + 1;
+        info->height = GMReadLE24(bytes + 27) + 1;
+    } else {
+        return GMImageHeaderStatusInvalid;
+    }
+    return GMImageHeaderStatusOK;
+}
+
+/**
+ Reads the orientation tag of the IFD0 of an APP1 Exif payload. Returns 1 (up) when absent or malformed.
+ */
+static uint32_t GMParseExifOrientation(const uint8_t *payload, size_t length)
+{
+    if (length < 14 || memcmp(payload, "Exif\0\0", 6) != 0) {
+        return 1;
+    }
+    
+    const uint8_t *tiff = payload + 6;
+    size_t tiffLength = length - 6;
+    int littleEndian;
+    if (tiff[0] == 'I' && tiff[1] == 'I') {
+        littleEndian = 1;
+    } else if (tiff[0] == 'M' && tiff[1] == 'M') {
+        littleEndian = 0;
+    } else {
+        return 1;
+    }
+    
+    uint32_t ifdOffset = GMReadTIFF32(tiff + 4, littleEndian);
+    if (ifdOffset > tiffLength - 2) {
+        return 1;
+    }
+    uint32_t entryCount = GMReadTIFF16(tiff + ifdOffset, littleEndian);
+    const uint8_t *entry = tiff + ifdOffset + 2;
+    for (uint32_t i = 0; i < entryCount; i++, entry += 12) {
+        if ((size_t)(entry + 12 - tiff) > tiffLength) {
+            break;
+        }
+        if (GMReadTIFF16(entry, littleEndian) == 0x0112) {
+            uint32_t orientation = GMReadTIFF16(entry + 8, littleEndian);
+            return orientation >= 1 && orientation <= 8 ? orientation : 1;
+        }
+    }
+    return 1;
+}
+
+static inline int GMIsJPEGStartOfFrame(uint8_t marker)
+{
+    // SOF0-SOF15, except DHT (C4), JPG (C8) and DAC (CC).
+    return marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc;
+}
+
+static GMImageHeaderStatus GMParseJPEG(const uint8_t *bytes, size_t length, GMImageHeaderInfo *info)
+{
+    uint32_t orientation = 1;
+    size_t offset = 2;
+    
+    while (1) {
+        // Markers may be preceded by any number of 0xff fill bytes.
+        if (offset >= length) {
+            return GMImageHeaderStatusNeedMoreData;
+        }
+        if (bytes[offset] != 0xff) {
+            return GMImageHeaderStatusInvalid;
+        }
+        while (offset < length && bytes[offset] == 0xff) {
+            offset++;
+        }
+        if (offset >= length) {
+            return GMImageHeaderStatusNeedMoreData;
+        }
+        
+        uint8_t marker = bytes[offset++];
+        if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7)) {
+            // Standalone markers, without a payload.
+            continue;
+        }
+        if (marker == 0xd9 || marker == 0xda) {
+            // End of image or start of scan before any frame header.
+            return GMImageHeaderStatusInvalid;
+        }
+        
+        if (offset + 2 > length) {
+            return GMImageHeaderStatusNeedMoreData;
+        }
+        size_t segmentLength = GMReadBE16(bytes + offset);
+        if (segmentLength < 2) {
+            return GMImageHeaderStatusInvalid;
+        }
+        
+        if (GMIsJPEGStartOfFrame(marker)) {
+            // Length, precision, height, width.
+            if (offset + 7 > length) {
+                return GMImageHeaderStatusNeedMoreData;
+            }
+            uint32_t height = GMReadBE16(bytes + offset + 3);
+            uint32_t width = GMReadBE16(bytes + offset + 5);
+            
+            // Orientations 5 to 8 transpose the image.
+            info->width = orientation >= 5 ? height : width;
+            info->height = orientation >= 5 ? width : height;
+            return GMImageHeaderStatusOK;
+        }
+        
+        if (offset + segmentLength > length) {
+            return GMImageHeaderStatusNeedMoreData;
+        }
+        if (marker == 0xe1) {
+            uint32_t exifOrientation = GMParseExifOrientation(bytes + offset + 2, segmentLength - 2);
+            if (exifOrientation != 1) {
+                orientation = exifOrientation;
+            }
+        }
+        offset += segmentLength;
+    }
+}
+
+GMImageHeaderStatus GMImageHeaderParse(const uint8_t *bytes, size_t length, GMImageHeaderInfo *info)
+{
+    static const char PNGSignature[] = "\x89PNG\r\n\x1a\n";
+    static const char JPEGSignature[] = "\xff\xd8";
+    static const char GIFSignature[] = "GIF8";
+    static const char RIFFSignature[] = "RIFF";
+    
+    if (bytes == NULL || info == NULL) {
+        return GMImageHeaderStatusInvalid;
+    }
+    if (length == 0) {
+        return GMImageHeaderStatusNeedMoreData;
+    }
+    
+    GMImageHeaderInfo result = { GMImageHeaderFormatUnknown, 0, 0 };
+    GMImageHeaderStatus status = GMImageHeaderStatusInvalid;
+    if ((status = GMMatchSignature(bytes, length, PNGSignature, 8)) != GMImageHeaderStatusInvalid) {
+        result.format = GMImageHeaderFormatPNG;
+        if (status == GMImageHeaderStatusOK) {
+            status = GMParsePNG(bytes, length, &result);
+        }
+    } else if ((status = GMMatchSignature(bytes, length, JPEGSignature, 2)) != GMImageHeaderStatusInvalid) {
+        result.format = GMImageHeaderFormatJPEG;
+        if (status == GMImageHeaderStatusOK) {
+            status = GMParseJPEG(bytes, length, &result);
+        }
+    } else if ((status = GMMatchSignature(bytes, length, GIFSignature, 4)) != GMImageHeaderStatusInvalid) {
+        result.format = GMImageHeaderFormatGIF;
+        if (status == GMImageHeaderStatusOK) {
+            status = GMParseGIF(bytes, length, &result);
+        }
+    } else if ((status = GMMatchSignature(bytes, length, RIFFSignature, 4)) != GMImageHeaderStatusInvalid) {
+        result.format = GMImageHeaderFormatWebP;
+        if (status == GMImageHeaderStatusOK) {
+            // "RIFF", file size, "WEBP".
+            status = length < 8 ? GMImageHeaderStatusNeedMoreData : GMMatchSignature(bytes + 8, length - 8, "WEBP", 4);
+            if (status == GMImageHeaderStatusOK) {
+                status = GMParseWebP(bytes, length, &result);
+            }
+        }
+    }
+    
+    if (status == GMImageHeaderStatusOK && (result.width == 0 || result.height == 0)) {
+        status = GMImageHeaderStatusInvalid;
+    }
+    if (status == GMImageHeaderStatusOK) {
+        *info = result;
+    }
+    return status;
+}
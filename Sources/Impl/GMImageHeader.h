@@ -0,0 +1,55 @@
+//
+//  GMImageHeader.h
+//  FlexLayout-OC
+//
+//  Reads the pixel size of an encoded image from its header, without decoding it.
+//  Plain C, independent of UIKit.
+//
+
+#ifndef GMImageHeader_h
+#define GMImageHeader_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GMImageHeaderFormatUnknown = 0,
+    GMImageHeaderFormatPNG,
+    GMImageHeaderFormatJPEG,
+    GMImageHeaderFormatGIF,
+    GMImageHeaderFormatWebP,
+} GMImageHeaderFormat;
+
+typedef enum {
+    /// The size was found.
+    GMImageHeaderStatusOK = 0,
+    /// The bytes are a prefix of a supported image, but the size lies further. Call again with more bytes.
+    GMImageHeaderStatusNeedMoreData,
+    /// The bytes are not a supported or valid image.
+    GMImageHeaderStatusInvalid,
+} GMImageHeaderStatus;
+
+typedef struct {
+    GMImageHeaderFormat format;
+    /// Displayed size in pixels. For JPEG, the EXIF orientation is applied like UIImage does.
+    uint32_t width;
+    uint32_t height;
+} GMImageHeaderInfo;
+
+/**
+ Parses the header of a PNG, JPEG, GIF or WebP image.
+ 
+ - Parameter bytes: the first `length` bytes of the encoded image.
+ - Parameter info: receives the format and size when `GMImageHeaderStatusOK` is returned.
+ */
+GMImageHeaderStatus GMImageHeaderParse(const uint8_t *bytes, size_t length, GMImageHeaderInfo *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GMImageHeader_h */
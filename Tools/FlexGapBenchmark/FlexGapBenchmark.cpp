@@ -0,0 +1,205 @@
+//
+//  FlexGapBenchmark.cpp
+//  FlexLayout-OC
+//
+//  Compares a list spaced with spacer items with the same list spaced with `gap`, laid out like FlexLayout does: the
+//  gap of a container is added to the margin of its items, on the side facing the previous item. The program checks
+//  that both lists put every visible item at the same frame, then reports their node counts and solve times.
+//
+//  Build, against the Yoga version used by the app:
+//      c++ -std=c++11 -O2 -I<yoga> FlexGapBenchmark.cpp <yoga>/yoga/*.cpp -o flex-gap-benchmark
+//
+//  Usage:
+//      flex-gap-benchmark [--rows <count>] [--iterations <count>]
+//
+
+#include <yoga/Yoga.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const float kListGap = 8;
+const float kRowGap = 12;
+const float kTextGap = 4;
+
+struct List {
+    YGNodeRef root = nullptr;
+    std::vector<YGNodeRef> items; // Every node but the spacers, in the same order for both lists.
+    size_t nodeCount = 0;
+};
+
+// A text leaf: one line of 7 points per character, wrapped on two lines when it doesn't fit.
+YGSize measureText(YGNodeRef node, float width, YGMeasureMode widthMode, float /*height*/, YGMeasureMode /*heightMode*/)
+{
+    const float length = 7.0f * static_cast<float>(reinterpret_cast<uintptr_t>(YGNodeGetContext(node)));
+    if (widthMode == YGMeasureModeUndefined || length <= width) {
+        return {length, 17};
+    }
+    return {width, 34};
+}
+
+YGNodeRef newNode(List *list, YGConfigRef config, YGNodeRef parent, bool isItem)
+{
+    YGNodeRef node = YGNodeNewWithConfig(config);
+    if (parent != nullptr) {
+        YGNodeInsertChild(parent, node, YGNodeGetChildCount(parent));
+    }
+    if (isItem) {
+        list->items.push_back(node);
+    }
+    list->nodeCount++;
+    return node;
+}
+
+YGNodeRef newText(List *list, YGConfigRef config, YGNodeRef parent, uintptr_t characterCount)
+{
+    YGNodeRef text = newNode(list, config, parent, true);
+    YGNodeSetContext(text, reinterpret_cast<void *>(characterCount));
+    YGNodeSetMeasureFunc(text, measureText);
+    return text;
+}
+
+// Spaces the items of a container: a spacer item before every item but the first one, or the gap added to the
+// leading margin of those items as `-[GMFlex applyGapMargins]` does.
+void space(List *list, YGConfigRef config, YGNodeRef container, float gap, bool usesSpacers)
+{
+    const bool isRow = YGNodeStyleGetFlexDirection(container) == YGFlexDirectionRow;
+    std::vector<YGNodeRef> items;
+    for (uint32_t i = 0; i < YGNodeGetChildCount(container); i++) {
+        items.push_back(YGNodeGetChild(container, i));
+    }
+    for (size_t i = 1; i < items.size(); i++) {
+        if (usesSpacers) {
+            YGNodeRef spacer = YGNodeNewWithConfig(config);
+            isRow ? YGNodeStyleSetWidth(spacer, gap) : YGNodeStyleSetHeight(spacer, gap);
+            YGNodeInsertChild(container, spacer, static_cast<uint32_t>(2 * i - 1));
+            list->nodeCount++;
+        } else {
+            const YGEdge edge = isRow ? YGEdgeLeft : YGEdgeTop;
+            const YGValue margin = YGNodeStyleGetMargin(items[i], edge);
+            YGNodeStyleSetMargin(items[i], edge, (margin.unit == YGUnitPoint ? margin.value : 0) + gap);
+        }
+    }
+}
+
+// A feed: rows made of an avatar, a title and a subtitle stacked, and a trailing badge.
+List buildList(YGConfigRef config, size_t rowCount, bool usesSpacers)
+{
+    List list;
+    list.root = newNode(&list, config, nullptr, true);
+    YGNodeStyleSetPadding(list.root, YGEdgeAll, 16);
+    for (size_t i = 0; i < rowCount; i++) {
+        YGNodeRef row = newNode(&list, config, list.root, true);
+        YGNodeStyleSetFlexDirection(row, YGFlexDirectionRow);
+        YGNodeStyleSetAlignItems(row, YGAlignCenter);
+
+        YGNodeRef avatar = newNode(&list, config, row, true);
+        YGNodeStyleSetWidth(avatar, 40);
+        YGNodeStyleSetHeight(avatar, 40);
+
+        YGNodeRef texts = newNode(&list, config, row, true);
+        YGNodeStyleSetFlexGrow(texts, 1);
+        YGNodeStyleSetFlexShrink(texts, 1);
+        newText(&list, config, texts, 12 + i % 7);
+        newText(&list, config, texts, 20 + i % 31);
+        space(&list, config, texts, kTextGap, usesSpacers);
+
+        YGNodeRef badge = newNode(&list, config, row, true);
+        YGNodeStyleSetWidth(badge, 24);
+        YGNodeStyleSetHeight(badge, 24);
+        space(&list, config, row, kRowGap, usesSpacers);
+    }
+    space(&list, config, list.root, kListGap, usesSpacers);
+    return list;
+}
+
+double solve(YGNodeRef root)
+{
+    const auto start = std::chrono::steady_clock::now();
+    YGNodeCalculateLayout(root, 375, YGUndefined, YGDirectionLTR);
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Largest difference between the frames of the items of both lists.
+float compareLists(const List &spacerList, const List &gapList)
+{
+    float difference = 0;
+    for (size_t i = 0; i < spacerList.items.size(); i++) {
+        YGNodeRef a = spacerList.items[i];
+        YGNodeRef b = gapList.items[i];
+        difference = std::max(difference, std::fabs(YGNodeLayoutGetLeft(a) - YGNodeLayoutGetLeft(b)));
+        difference = std::max(difference, std::fabs(YGNodeLayoutGetTop(a) - YGNodeLayoutGetTop(b)));
+        difference = std::max(difference, std::fabs(YGNodeLayoutGetWidth(a) - YGNodeLayoutGetWidth(b)));
+        difference = std::max(difference, std::fabs(YGNodeLayoutGetHeight(a) - YGNodeLayoutGetHeight(b)));
+    }
+    return difference;
+}
+
+// Median solve time of a freshly built list, so that no Yoga cache survives between iterations.
+double medianSolveTime(YGConfigRef config, size_t rowCount, bool usesSpacers, int iterations)
+{
+    std::vector<double> durations;
+    for (int i = 0; i < iterations; i++) {
+        List list = buildList(config, rowCount, usesSpacers);
+        durations.push_back(solve(list.root));
+        YGNodeFreeRecursive(list.root);
+    }
+    std::sort(durations.begin(), durations.end());
+    return durations[durations.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    size_t rowCount = 50;
+    int iterations = 200;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            rowCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--rows <count>] [--iterations <count>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    YGConfigRef config = YGConfigNew();
+    YGConfigSetPointScaleFactor(config, 3);
+    YGConfigSetExperimentalFeatureEnabled(config, YGExperimentalFeatureWebFlexBasis, true); // Like YogaKit
+
+    List spacerList = buildList(config, rowCount, true);
+    List gapList = buildList(config, rowCount, false);
+    solve(spacerList.root);
+    solve(gapList.root);
+    const float difference = compareLists(spacerList, gapList);
+    const size_t spacerNodeCount = spacerList.nodeCount;
+    const size_t gapNodeCount = gapList.nodeCount;
+    YGNodeFreeRecursive(spacerList.root);
+    YGNodeFreeRecursive(gapList.root);
+
+    const double spacerTime = medianSolveTime(config, rowCount, true, iterations);
+    const double gapTime = medianSolveTime(config, rowCount, false, iterations);
+    YGConfigFree(config);
+
+    std::printf("rows: %zu, iterations: %d\n", rowCount, iterations);
+    std::printf("spacers: %zu nodes, median solve %.1f us\n", spacerNodeCount, spacerTime);
+    std::printf("gaps:    %zu nodes, median solve %.1f us\n", gapNodeCount, gapTime);
+    std::printf("nodes: -%.0f%%, solve time: -%.0f%%\n",
+                100.0 * (1.0 - static_cast<double>(gapNodeCount) / spacerNodeCount), 100.0 * (1.0 - gapTime / spacerTime));
+    if (difference > 0) {
+        std::printf("The lists differ: max frame difference %g\n", difference);
+        return 1;
+    }
+    std::printf("Both lists lay out their items at the same frames.\n");
+    return 0;
+}
@@ -0,0 +1,279 @@
+//
+//  FlexGridCheck.cpp
+//  FlexLayout-OC
+//
+//  Checks the closed-form grid layout of `GMFlexGrid.h` against Yoga, then compares their speed. Every fixture is
+//  laid out both ways, the way `-[GMFlex layout]` does: Yoga solves the whole tree, while the grid path computes the
+//  item frames and solves each item subtree on its own, as a root. Both must give the same frames, to the bit.
+//
+//  Build, against the Yoga version used by the app:
+//      cc -std=c99 -O2 -I<yoga> -c ../../Sources/Impl/GMFlexGrid.c ../../Sources/Impl/GMFlexStyle.c
+//      c++ -std=c++11 -O2 -I<yoga> -I../../Sources/Impl FlexGridCheck.cpp GMFlexGrid.o GMFlexStyle.o <yoga>/yoga/*.cpp -o flex-grid-check
+//
+//  Usage:
+//      flex-grid-check [--items <count>] [--iterations <count>]
+//
+
+#include "GMFlexGrid.h"
+
+#include <yoga/Yoga.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Frame {
+    float left;
+    float top;
+    float width;
+    float height;
+};
+
+// A grid: a wrapping container of identical items, optionally holding a subtree, laid out at a given size.
+struct Fixture {
+    const char *name;
+    float scale;
+    bool isRow;
+    float width; // YGUndefined when adjusted to the content
+    float height;
+    float padding[4]; // left, top, right, bottom
+    YGAlign alignItems;
+    float itemWidth;
+    float itemHeight;
+    float itemMargin[4];
+    bool hasSubtree;
+    size_t itemCount;
+    bool isEligible; // Whether the grid path is expected to handle the fixture
+};
+
+const Fixture kFixtures[] = {
+    {"photo grid", 3, true, 375, YGUndefined, {2, 2, 2, 2}, YGAlignStretch, 123, 123, {0, 0, 0, 0}, false, 100, true},
+    {"photo grid with margins", 2, true, 375, YGUndefined, {10, 10, 10, 10}, YGAlignStretch, 80, 80, {5, 5, 5, 5}, false, 37, true},
+    {"fractional sizes", 3, true, 320, YGUndefined, {0, 0, 0, 0}, YGAlignStretch, 106.5f, 40.25f, {0.5f, 0, 0, 0.75f}, false, 25, true},
+    {"column", 2, false, YGUndefined, 600, {8, 4, 8, 4}, YGAlignFlexStart, 90, 100, {2, 2, 2, 2}, false, 20, true},
+    {"centered items", 3, true, 414, 200, {0, 0, 0, 0}, YGAlignCenter, 100, 60, {1, 2, 3, 4}, false, 4, true},
+    {"single line at the end", 2, true, 414, 200, {6, 6, 6, 6}, YGAlignFlexEnd, 50, 50, {0, 0, 0, 0}, false, 3, true},
+    {"oversized item", 2, true, 100, YGUndefined, {0, 0, 0, 0}, YGAlignStretch, 150, 30, {0, 0, 0, 0}, false, 3, true},
+    {"cards", 3, true, 375, YGUndefined, {16, 16, 16, 16}, YGAlignStretch, 165, 200, {0, 0, 13, 13}, true, 12, true},
+    {"cards with margins", 2, true, 375, YGUndefined, {10, 10, 10, 10}, YGAlignStretch, 110, 140, {5, 5, 5, 5}, true, 9, true},
+    {"cards off the pixel grid", 3, true, 375, YGUndefined, {0, 0, 0, 0}, YGAlignStretch, 100.25f, 140, {0.5f, 0, 0, 0}, true, 9, false},
+};
+
+void setEdges(YGNodeRef node, const float *edges, void (*setter)(YGNodeRef, YGEdge, float))
+{
+    const YGEdge physicalEdges[] = {YGEdgeLeft, YGEdgeTop, YGEdgeRight, YGEdgeBottom};
+    for (YGEdge physicalEdge : physicalEdges) {
+        if (edges[physicalEdge] != 0) {
+            setter(node, physicalEdge, edges[physicalEdge]);
+        }
+    }
+}
+
+// A card: an image filling the width and a caption row, both with margins, so that positions and sizes depend on
+// the rounding of the whole subtree.
+void addSubtree(YGConfigRef config, YGNodeRef item)
+{
+    YGNodeStyleSetPadding(item, YGEdgeAll, 3);
+    YGNodeRef image = YGNodeNewWithConfig(config);
+    YGNodeStyleSetFlexGrow(image, 1);
+    YGNodeStyleSetMargin(image, YGEdgeAll, 2.5f);
+    YGNodeInsertChild(item, image, 0);
+
+    YGNodeRef caption = YGNodeNewWithConfig(config);
+    YGNodeStyleSetFlexDirection(caption, YGFlexDirectionRow);
+    YGNodeStyleSetHeight(caption, 20.3f);
+    YGNodeInsertChild(item, caption, 1);
+    for (uint32_t i = 0; i < 2; i++) {
+        YGNodeRef text = YGNodeNewWithConfig(config);
+        YGNodeStyleSetFlexGrow(text, 1);
+        YGNodeStyleSetMarginPercent(text, YGEdgeLeft, 3);
+        YGNodeInsertChild(caption, text, i);
+    }
+}
+
+YGNodeRef buildGrid(YGConfigRef config, const Fixture &fixture, std::vector<YGNodeRef> *items)
+{
+    YGNodeRef container = YGNodeNewWithConfig(config);
+    YGNodeStyleSetFlexDirection(container, fixture.isRow ? YGFlexDirectionRow : YGFlexDirectionColumn);
+    YGNodeStyleSetFlexWrap(container, YGWrapWrap);
+    if (fixture.alignItems != YGAlignStretch) {
+        YGNodeStyleSetAlignItems(container, fixture.alignItems);
+    }
+    setEdges(container, fixture.padding, YGNodeStyleSetPadding);
+    for (size_t i = 0; i < fixture.itemCount; i++) {
+        YGNodeRef item = YGNodeNewWithConfig(config);
+        YGNodeStyleSetWidth(item, fixture.itemWidth);
+        YGNodeStyleSetHeight(item, fixture.itemHeight);
+        setEdges(item, fixture.itemMargin, YGNodeStyleSetMargin);
+        if (fixture.hasSubtree) {
+            addSubtree(config, item);
+        }
+        YGNodeInsertChild(container, item, static_cast<uint32_t>(i));
+        items->push_back(item);
+    }
+    return container;
+}
+
+Frame frameOfNode(YGNodeRef node)
+{
+    return {YGNodeLayoutGetLeft(node), YGNodeLayoutGetTop(node), YGNodeLayoutGetWidth(node), YGNodeLayoutGetHeight(node)};
+}
+
+// Appends the frames of the descendants of `node`, depth-first.
+void collectFrames(YGNodeRef node, std::vector<Frame> *frames)
+{
+    for (uint32_t i = 0; i < YGNodeGetChildCount(node); i++) {
+        YGNodeRef child = YGNodeGetChild(node, i);
+        frames->push_back(frameOfNode(child));
+        collectFrames(child, frames);
+    }
+}
+
+bool framesEqual(const Frame &a, const Frame &b)
+{
+    return a.left == b.left && a.top == b.top && a.width == b.width && a.height == b.height;
+}
+
+bool reportDifference(const char *name, const char *what, size_t index, const Frame &expected, const Frame &actual)
+{
+    if (framesEqual(expected, actual)) {
+        return false;
+    }
+    std::printf("%s: %s %zu is {%g, %g, %g, %g}, Yoga gives {%g, %g, %g, %g}\n", name, what, index, actual.left,
+                actual.top, actual.width, actual.height, expected.left, expected.top, expected.width, expected.height);
+    return true;
+}
+
+// Lays out a fixture both ways. Returns false if they differ or if the grid path eligibility isn't the expected one.
+bool checkFixture(const Fixture &fixture)
+{
+    YGConfigRef config = YGConfigNew();
+    YGConfigSetPointScaleFactor(config, fixture.scale);
+    YGConfigSetExperimentalFeatureEnabled(config, YGExperimentalFeatureWebFlexBasis, true); // Like YogaKit
+    std::vector<YGNodeRef> items;
+    YGNodeRef container = buildGrid(config, fixture, &items);
+
+    YGNodeCalculateLayout(container, fixture.width, fixture.height, YGDirectionLTR);
+    const Frame expectedContainer = frameOfNode(container);
+    std::vector<Frame> expectedItems;
+    std::vector<Frame> expectedSubtrees;
+    for (YGNodeRef item : items) {
+        expectedItems.push_back(frameOfNode(item));
+        collectFrames(item, &expectedSubtrees);
+    }
+
+    std::vector<GMFlexGridFrame> frames(items.size());
+    GMFlexGridLayoutResult result;
+    const bool isEligible = GMFlexGridLayout(container, items.data(), items.size(), fixture.width, fixture.height,
+                                             fixture.scale, frames.data(), &result) &&
+                            (result.isOnPixelGrid || !fixture.hasSubtree);
+    bool isPassing = isEligible == fixture.isEligible;
+    if (!isPassing) {
+        std::printf("%s: the grid path %s the fixture\n", fixture.name, isEligible ? "handles" : "rejects");
+    }
+    if (isEligible) {
+        // The grid path keeps the container origin and gives it the Yoga size.
+        const Frame container = {expectedContainer.left, expectedContainer.top, result.width, result.height};
+        isPassing = !reportDifference(fixture.name, "container", 0, expectedContainer, container) && isPassing;
+
+        std::vector<Frame> subtrees;
+        for (size_t i = 0; i < items.size(); i++) {
+            const Frame item = {frames[i].left, frames[i].top, frames[i].width, frames[i].height};
+            isPassing = !reportDifference(fixture.name, "item", i, expectedItems[i], item) && isPassing;
+            if (YGNodeGetChildCount(items[i]) > 0) {
+                YGNodeCalculateLayout(items[i], item.width, item.height, YGDirectionLTR);
+                collectFrames(items[i], &subtrees);
+            }
+        }
+        for (size_t i = 0; i < subtrees.size(); i++) {
+            isPassing = !reportDifference(fixture.name, "subtree node", i, expectedSubtrees[i], subtrees[i]) && isPassing;
+        }
+    }
+
+    YGNodeFreeRecursive(container);
+    YGConfigFree(config);
+    return isPassing;
+}
+
+double elapsed(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(std::vector<double> durations)
+{
+    std::sort(durations.begin(), durations.end());
+    return durations[durations.size() / 2];
+}
+
+// Median layout times of a photo grid, with Yoga on freshly built trees, so that no Yoga cache survives between
+// iterations, and with the grid path.
+void benchmark(size_t itemCount, int iterations)
+{
+    Fixture fixture = kFixtures[0];
+    fixture.itemCount = itemCount;
+    YGConfigRef config = YGConfigNew();
+    YGConfigSetPointScaleFactor(config, fixture.scale);
+    YGConfigSetExperimentalFeatureEnabled(config, YGExperimentalFeatureWebFlexBasis, true); // Like YogaKit
+
+    std::vector<double> yogaDurations;
+    std::vector<double> gridDurations;
+    std::vector<GMFlexGridFrame> frames(itemCount);
+    for (int i = 0; i < iterations; i++) {
+        std::vector<YGNodeRef> items;
+        YGNodeRef container = buildGrid(config, fixture, &items);
+        auto start = std::chrono::steady_clock::now();
+        YGNodeCalculateLayout(container, fixture.width, fixture.height, YGDirectionLTR);
+        yogaDurations.push_back(elapsed(start));
+
+        GMFlexGridLayoutResult result;
+        start = std::chrono::steady_clock::now();
+        GMFlexGridLayout(container, items.data(), items.size(), fixture.width, fixture.height, fixture.scale,
+                         frames.data(), &result);
+        gridDurations.push_back(elapsed(start));
+        YGNodeFreeRecursive(container);
+    }
+    YGConfigFree(config);
+
+    const double yogaTime = median(yogaDurations);
+    const double gridTime = median(gridDurations);
+    std::printf("%zu items, %d iterations\n", itemCount, iterations);
+    std::printf("yoga: median %.1f us\n", yogaTime);
+    std::printf("grid: median %.1f us (%.1fx)\n", gridTime, yogaTime / gridTime);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    size_t itemCount = 1000;
+    int iterations = 200;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--items") == 0 && i + 1 < argc) {
+            itemCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--items <count>] [--iterations <count>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    size_t failureCount = 0;
+    for (const Fixture &fixture : kFixtures) {
+        if (!checkFixture(fixture)) {
+            failureCount++;
+        }
+    }
+    std::printf("%zu of %zu fixtures laid out like Yoga.\n", sizeof(kFixtures) / sizeof(kFixtures[0]) - failureCount,
+                sizeof(kFixtures) / sizeof(kFixtures[0]));
+
+    benchmark(itemCount, iterations);
+    return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,537 @@
+//
+//  FlexReplay.cpp
+//  FlexLayout-OC
+//
+//  Rebuilds a layout captured with `-[GMFlex captureLayoutWithMode:toFile:]` and times its solve, without UIKit.
+//  Leaves replay the results of the measure function calls recorded at capture time, looked up by their constraints.
+//
+//  Build, against the Yoga version used by the app:
+//      c++ -std=c++11 -O2 -I<yoga> FlexReplay.cpp <yoga>/yoga/*.cpp -o flex-replay
+//
+//  Usage:
+//      flex-replay <capture> [--iterations <count>] [--trace <trace.json>]
+//
+//  The trace is a Chrome trace event file (chrome://tracing, Perfetto): the first track holds every timed solve,
+//  the second one an estimated flame chart of the tree. Yoga can't time the subtrees of a solve, so each container
+//  is timed by solving its subtree alone with its captured size, and drawn within its parent's duration. It shows
+//  where the time goes, not the actual solve.
+//
+
+#include <yoga/Yoga.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../../Sources/Impl/GMFlexCapture.h"
+
+namespace {
+
+struct Measurement {
+    float width;
+    YGMeasureMode widthMode;
+    float height;
+    YGMeasureMode heightMode;
+    YGSize size;
+};
+
+struct CapturedNode {
+    unsigned depth = 0;
+    std::vector<std::pair<std::string, std::string>> properties;
+    std::vector<Measurement> measurements;
+    float rowGap = 0;
+    float columnGap = 0;
+    float frame[4] = {0, 0, 0, 0};
+    std::vector<size_t> children;
+};
+
+struct Capture {
+    int layoutMode = 0;
+    float width = YGUndefined;
+    float height = YGUndefined;
+    GMFlexCaptureConfig config = {1, 0, false, false};
+    std::vector<CapturedNode> nodes;
+};
+
+struct TraceEvent {
+    std::string name;
+    int threadId;
+    double timestamp; // Microseconds.
+    double duration; // Microseconds.
+};
+
+const char *const kEdgeNames[] = {"left", "top", "right", "bottom", "start", "end", "horizontal", "vertical", "all"};
+
+bool parseEdge(const std::string &name, YGEdge *edge)
+{
+    for (int i = YGEdgeLeft; i <= YGEdgeAll; i++) {
+        if (name == kEdgeNames[i]) {
+            *edge = static_cast<YGEdge>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+float parseFloat(const std::string &value)
+{
+    return std::strtof(value.c_str(), nullptr);
+}
+
+bool isPercent(const std::string &value)
+{
+    return !value.empty() && value.back() == '%';
+}
+
+// Applies one `<property>=<value>` of a node line. Returns false for an unknown property.
+bool applyProperty(YGNodeRef node, const std::string &key, const std::string &value)
+{
+    const float number = parseFloat(value);
+    const int enumValue = std::atoi(value.c_str());
+    const bool percent = isPercent(value);
+    const bool isAuto = value == "auto";
+
+    if (key == "direction") {
+        YGNodeStyleSetDirection(node, static_cast<YGDirection>(enumValue));
+    } else if (key == "flexDirection") {
+        YGNodeStyleSetFlexDirection(node, static_cast<YGFlexDirection>(enumValue));
+    } else if (key == "justifyContent") {
+        YGNodeStyleSetJustifyContent(node, static_cast<YGJustify>(enumValue));
+    } else if (key == "alignContent") {
+        YGNodeStyleSetAlignContent(node, static_cast<YGAlign>(enumValue));
+    } else if (key == "alignItems") {
+        YGNodeStyleSetAlignItems(node, static_cast<YGAlign>(enumValue));
+    } else if (key == "alignSelf") {
+        YGNodeStyleSetAlignSelf(node, static_cast<YGAlign>(enumValue));
+    } else if (key == "positionType") {
+        YGNodeStyleSetPositionType(node, static_cast<YGPositionType>(enumValue));
+    } else if (key == "flexWrap") {
+        YGNodeStyleSetFlexWrap(node, static_cast<YGWrap>(enumValue));
+    } else if (key == "overflow") {
+        YGNodeStyleSetOverflow(node, static_cast<YGOverflow>(enumValue));
+    } else if (key == "display") {
+        YGNodeStyleSetDisplay(node, static_cast<YGDisplay>(enumValue));
+    } else if (key == "flexGrow") {
+        YGNodeStyleSetFlexGrow(node, number);
+    } else if (key == "flexShrink") {
+        YGNodeStyleSetFlexShrink(node, number);
+    } else if (key == "aspectRatio") {
+        YGNodeStyleSetAspectRatio(node, number);
+    } else if (key == "flexBasis") {
+        isAuto ? YGNodeStyleSetFlexBasisAuto(node) : percent ? YGNodeStyleSetFlexBasisPercent(node, number) : YGNodeStyleSetFlexBasis(node, number);
+    } else if (key == "width") {
+        isAuto ? YGNodeStyleSetWidthAuto(node) : percent ? YGNodeStyleSetWidthPercent(node, number) : YGNodeStyleSetWidth(node, number);
+    } else if (key == "height") {
+        isAuto ? YGNodeStyleSetHeightAuto(node) : percent ? YGNodeStyleSetHeightPercent(node, number) : YGNodeStyleSetHeight(node, number);
+    } else if (key == "minWidth") {
+        percent ? YGNodeStyleSetMinWidthPercent(node, number) : YGNodeStyleSetMinWidth(node, number);
+    } else if (key == "minHeight") {
+        percent ? YGNodeStyleSetMinHeightPercent(node, number) : YGNodeStyleSetMinHeight(node, number);
+    } else if (key == "maxWidth") {
+        percent ? YGNodeStyleSetMaxWidthPercent(node, number) : YGNodeStyleSetMaxWidth(node, number);
+    } else if (key == "maxHeight") {
+        percent ? YGNodeStyleSetMaxHeightPercent(node, number) : YGNodeStyleSetMaxHeight(node, number);
+    } else {
+        const size_t dot = key.find('.');
+        YGEdge edge;
+        if (dot == std::string::npos || !parseEdge(key.substr(dot + 1), &edge)) {
+            return false;
+        }
+
+        const std::string property = key.substr(0, dot);
+        if (property == "margin") {
+            isAuto ? YGNodeStyleSetMarginAuto(node, edge) : percent ? YGNodeStyleSetMarginPercent(node, edge, number) : YGNodeStyleSetMargin(node, edge, number);
+        } else if (property == "padding") {
+            percent ? YGNodeStyleSetPaddingPercent(node, edge, number) : YGNodeStyleSetPadding(node, edge, number);
+        } else if (property == "position") {
+            percent ? YGNodeStyleSetPositionPercent(node, edge, number) : YGNodeStyleSetPosition(node, edge, number);
+        } else if (property == "border") {
+            YGNodeStyleSetBorder(node, edge, number);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseCapture(std::istream &input, Capture *capture, std::string *error)
+{
+    std::string line;
+    int version = 0;
+    if (!std::getline(input, line) || std::sscanf(line.c_str(), "gmflex-capture %d", &version) != 1) {
+        *error = "not a GMFlex capture";
+        return false;
+    }
+    if (version != GMFLEX_CAPTURE_VERSION) {
+        *error = "unsupported capture version " + std::to_string(version);
+        return false;
+    }
+
+    std::vector<size_t> ancestors; // Index of the last node seen at each depth.
+    while (std::getline(input, line)) {
+        std::istringstream tokens(line);
+        std::string recordType;
+        tokens >> recordType;
+
+        if (recordType == "layout") {
+            std::string token;
+            while (tokens >> token) {
+                const size_t equal = token.find('=');
+                const std::string key = token.substr(0, equal);
+                const float value = parseFloat(token.substr(equal + 1));
+                if (key == "mode") {
+                    capture->layoutMode = static_cast<int>(value);
+                } else if (key == "width") {
+                    capture->width = value;
+                } else if (key == "height") {
+                    capture->height = value;
+                }
+            }
+        } else if (recordType == "config") {
+            std::string token;
+            while (tokens >> token) {
+                const size_t equal = token.find('=');
+                const std::string key = token.substr(0, equal);
+                const float value = parseFloat(token.substr(equal + 1));
+                if (key == "scale") {
+                    capture->config.pointScaleFactor = value;
+                } else if (key == "experimentalFeatures") {
+                    capture->config.experimentalFeatures = static_cast<uint32_t>(std::strtoul(token.c_str() + equal + 1, nullptr, 10));
+                } else if (key == "useWebDefaults") {
+                    capture->config.useWebDefaults = value != 0;
+                } else if (key == "useLegacyStretchBehaviour") {
+                    capture->config.useLegacyStretchBehaviour = value != 0;
+                }
+            }
+        } else if (recordType == "node") {
+            CapturedNode node;
+            tokens >> node.depth;
+            if (node.depth > ancestors.size() || (node.depth == 0 && !capture->nodes.empty())) {
+                *error = "malformed tree at line: " + line;
+                return false;
+            }
+
+            std::string token;
+            while (tokens >> token) {
+                const size_t equal = token.find('=');
+                if (equal == std::string::npos) {
+                    *error = "malformed property: " + token;
+                    return false;
+                }
+                const std::string key = token.substr(0, equal);
+                const std::string value = token.substr(equal + 1);
+                if (key == "measure") {
+                    Measurement measurement;
+                    int widthMode = 0;
+                    int heightMode = 0;
+                    if (std::sscanf(value.c_str(), "%f,%d,%f,%d,%f,%f", &measurement.width, &widthMode, &measurement.height,
+                                    &heightMode, &measurement.size.width, &measurement.size.height) != 6) {
+                        *error = "malformed measurement: " + token;
+                        return false;
+                    }
+                    measurement.widthMode = static_cast<YGMeasureMode>(widthMode);
+                    measurement.heightMode = static_cast<YGMeasureMode>(heightMode);
+                    node.measurements.push_back(measurement);
+                } else if (key == "rowGap") {
+                    node.rowGap = parseFloat(value);
+                } else if (key == "columnGap") {
+                    node.columnGap = parseFloat(value);
+                } else if (key == "frame") {
+                    std::sscanf(value.c_str(), "%f,%f,%f,%f", &node.frame[0], &node.frame[1], &node.frame[2], &node.frame[3]);
+                } else {
+                    node.properties.emplace_back(key, value);
+                }
+            }
+
+            const size_t index = capture->nodes.size();
+            ancestors.resize(node.depth);
+            if (node.depth > 0) {
+                capture->nodes[ancestors.back()].children.push_back(index);
+            }
+            ancestors.push_back(index);
+            capture->nodes.push_back(std::move(node));
+        }
+    }
+
+    if (capture->nodes.empty()) {
+        *error = "the capture has no node";
+        return false;
+    }
+    return true;
+}
+
+// Measure calls whose constraints weren't recorded at capture time.
+size_t missedMeasurementCount = 0;
+
+bool constraintEquals(float a, YGMeasureMode aMode, float b, YGMeasureMode bMode)
+{
+    return aMode == bMode && (aMode == YGMeasureModeUndefined || a == b);
+}
+
+// Replays the measurement made by UIKit at capture time with the same constraints. Calls with other constraints,
+// which only a subtree solved alone makes, get the last recorded size within the constraints.
+YGSize measureCapturedNode(YGNodeRef node, float width, YGMeasureMode widthMode, float height, YGMeasureMode heightMode)
+{
+    const CapturedNode *capturedNode = static_cast<const CapturedNode *>(YGNodeGetContext(node));
+    for (const Measurement &measurement : capturedNode->measurements) {
+        if (constraintEquals(measurement.width, measurement.widthMode, width, widthMode) &&
+            constraintEquals(measurement.height, measurement.heightMode, height, heightMode)) {
+            return measurement.size;
+        }
+    }
+
+    missedMeasurementCount++;
+    YGSize size = capturedNode->measurements.back().size;
+    if (widthMode == YGMeasureModeExactly) {
+        size.width = width;
+    } else if (widthMode == YGMeasureModeAtMost) {
+        size.width = std::min(size.width, width);
+    }
+    if (heightMode == YGMeasureModeExactly) {
+        size.height = height;
+    } else if (heightMode == YGMeasureModeAtMost) {
+        size.height = std::min(size.height, height);
+    }
+    return size;
+}
+
+bool isRow(YGFlexDirection flexDirection)
+{
+    return flexDirection == YGFlexDirectionRow || flexDirection == YGFlexDirectionRowReverse;
+}
+
+// Margin edge Yoga reads for the side of an item facing the previous one, see GMFlexLeadingMarginEdge.
+YGEdge leadingMarginEdge(YGNodeRef node, YGFlexDirection flexDirection, YGDirection direction)
+{
+    if (isRow(flexDirection)) {
+        if (YGNodeStyleGetMargin(node, YGEdgeStart).unit != YGUnitUndefined) {
+            return YGEdgeStart;
+        }
+        const bool isReversed = (flexDirection == YGFlexDirectionRowReverse) != (direction == YGDirectionRTL);
+        return isReversed ? YGEdgeRight : YGEdgeLeft;
+    }
+    return flexDirection == YGFlexDirectionColumn ? YGEdgeTop : YGEdgeBottom;
+}
+
+// Point margin of a node on an edge with Yoga's fallbacks, see GMFlexPointMargin. Returns false for other units.
+bool pointMargin(YGNodeRef node, YGEdge edge, float *margin)
+{
+    YGValue value = YGNodeStyleGetMargin(node, edge);
+    if (value.unit == YGUnitUndefined && edge != YGEdgeStart && edge != YGEdgeEnd) {
+        value = YGNodeStyleGetMargin(node, edge == YGEdgeLeft || edge == YGEdgeRight ? YGEdgeHorizontal : YGEdgeVertical);
+    }
+    if (value.unit == YGUnitUndefined) {
+        value = YGNodeStyleGetMargin(node, YGEdgeAll);
+    }
+    *margin = value.unit == YGUnitUndefined ? 0 : value.value;
+    return value.unit == YGUnitUndefined || value.unit == YGUnitPoint;
+}
+
+// Adds the gap of a container to the margins of its items, like FlexLayout does before calculating: every item in
+// flow but the first one gets the main axis gap on the side facing the previous item. Wrapping containers have none.
+void addGapMargins(YGNodeRef node, const CapturedNode &capturedNode, YGDirection direction)
+{
+    const YGFlexDirection flexDirection = YGNodeStyleGetFlexDirection(node);
+    const float gap = isRow(flexDirection) ? capturedNode.columnGap : capturedNode.rowGap;
+    if (gap == 0 || YGNodeStyleGetFlexWrap(node) != YGWrapNoWrap) {
+        return;
+    }
+
+    bool hasPreviousItem = false;
+    for (uint32_t i = 0; i < YGNodeGetChildCount(node); i++) {
+        YGNodeRef child = YGNodeGetChild(node, i);
+        if (YGNodeStyleGetPositionType(child) == YGPositionTypeAbsolute || YGNodeStyleGetDisplay(child) == YGDisplayNone) {
+            continue;
+        }
+        const YGEdge edge = leadingMarginEdge(child, flexDirection, direction);
+        float margin;
+        if (hasPreviousItem && pointMargin(child, edge, &margin)) {
+            YGNodeStyleSetMargin(child, edge, margin + gap);
+        }
+        hasPreviousItem = true;
+    }
+}
+
+YGNodeRef buildTree(const Capture &capture, size_t index, YGConfigRef config, YGDirection direction)
+{
+    const CapturedNode &capturedNode = capture.nodes[index];
+    YGNodeRef node = YGNodeNewWithConfig(config);
+    for (const auto &property : capturedNode.properties) {
+        if (!applyProperty(node, property.first, property.second)) {
+            std::cerr << "warning: ignoring unknown property " << property.first << std::endl;
+        }
+    }
+    if (YGNodeStyleGetDirection(node) != YGDirectionInherit) {
+        direction = YGNodeStyleGetDirection(node);
+    }
+
+    if (!capturedNode.measurements.empty()) {
+        YGNodeSetContext(node, const_cast<CapturedNode *>(&capturedNode));
+        YGNodeSetMeasureFunc(node, measureCapturedNode);
+    }
+
+    uint32_t childIndex = 0;
+    for (size_t child : capturedNode.children) {
+        YGNodeInsertChild(node, buildTree(capture, child, config, direction), childIndex++);
+    }
+    addGapMargins(node, capturedNode, direction);
+    return node;
+}
+
+// Largest difference between the solved frames and the captured ones.
+float compareFrames(const Capture &capture, size_t index, YGNodeRef node)
+{
+    const CapturedNode &capturedNode = capture.nodes[index];
+    const float frame[4] = {YGNodeLayoutGetLeft(node), YGNodeLayoutGetTop(node), YGNodeLayoutGetWidth(node), YGNodeLayoutGetHeight(node)};
+    float difference = 0;
+    for (int i = 0; i < 4; i++) {
+        difference = std::max(difference, std::fabs(frame[i] - capturedNode.frame[i]));
+    }
+    for (size_t i = 0; i < capturedNode.children.size(); i++) {
+        difference = std::max(difference, compareFrames(capture, capturedNode.children[i], YGNodeGetChild(node, static_cast<uint32_t>(i))));
+    }
+    return difference;
+}
+
+double solve(YGNodeRef node, float width, float height)
+{
+    const auto start = std::chrono::steady_clock::now();
+    YGNodeCalculateLayout(node, width, height, YGNodeStyleGetDirection(node));
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Estimates the time spent in a subtree by solving it alone with its captured size, clamped to the time left in its
+// parent's event, then lays out its containers inside its event. Returns the duration of the subtree event.
+double traceSubtree(const Capture &capture, size_t index, YGConfigRef config, double timestamp, double maxDuration, std::vector<TraceEvent> *events)
+{
+    const CapturedNode &capturedNode = capture.nodes[index];
+    YGNodeRef node = buildTree(capture, index, config, YGDirectionLTR);
+    const double duration = std::min(solve(node, capturedNode.frame[2], capturedNode.frame[3]), maxDuration);
+    YGNodeFreeRecursive(node);
+
+    std::ostringstream name;
+    name << "node " << index << " (" << capturedNode.children.size() << " children)";
+    events->push_back({name.str(), 2, timestamp, duration});
+
+    double childTimestamp = timestamp;
+    for (size_t child : capture.nodes[index].children) {
+        if (capture.nodes[child].children.empty()) {
+            continue;
+        }
+        const double remaining = timestamp + duration - childTimestamp;
+        if (remaining <= 0) {
+            break;
+        }
+        childTimestamp += traceSubtree(capture, child, config, childTimestamp, remaining, events);
+    }
+    return duration;
+}
+
+bool writeTrace(const std::string &path, const std::vector<TraceEvent> &events)
+{
+    std::ofstream output(path);
+    output << "{\"traceEvents\":[\n";
+    output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Solves\"}},\n";
+    output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"Subtrees (estimated)\"}}";
+    for (const TraceEvent &event : events) {
+        output << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"layout\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId
+               << ",\"ts\":" << event.timestamp << ",\"dur\":" << event.duration << "}";
+    }
+    output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return static_cast<bool>(output);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string capturePath;
+    std::string tracePath;
+    int iterations = 100;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else if (capturePath.empty()) {
+            capturePath = argv[i];
+        } else {
+            capturePath.clear();
+            break;
+        }
+    }
+    if (capturePath.empty()) {
+        std::cerr << "usage: " << argv[0] << " <capture> [--iterations <count>] [--trace <trace.json>]" << std::endl;
+        return 2;
+    }
+
+    std::ifstream input(capturePath);
+    Capture capture;
+    std::string error;
+    if (!input || !parseCapture(input, &capture, &error)) {
+        std::cerr << capturePath << ": " << (input ? error : "cannot open file") << std::endl;
+        return 1;
+    }
+
+    // Same configuration as the captured app, YogaKit's one enabling experimental features.
+    YGConfigRef config = YGConfigNew();
+    YGConfigSetPointScaleFactor(config, capture.config.pointScaleFactor);
+    for (int feature = 0; feature < YGExperimentalFeatureCount; feature++) {
+        YGConfigSetExperimentalFeatureEnabled(config, static_cast<YGExperimentalFeature>(feature),
+                                              (capture.config.experimentalFeatures & (1u << feature)) != 0);
+    }
+    YGConfigSetUseWebDefaults(config, capture.config.useWebDefaults);
+    YGConfigSetUseLegacyStretchBehaviour(config, capture.config.useLegacyStretchBehaviour);
+
+    // Every iteration solves a freshly built tree, so that no Yoga cache survives between iterations.
+    std::vector<double> durations;
+    std::vector<TraceEvent> events;
+    float difference = 0;
+    double timestamp = 0;
+    for (int i = 0; i < iterations; i++) {
+        YGNodeRef root = buildTree(capture, 0, config, YGDirectionLTR);
+        const double duration = solve(root, capture.width, capture.height);
+        if (i == 0) {
+            difference = compareFrames(capture, 0, root);
+        }
+        YGNodeFreeRecursive(root);
+
+        durations.push_back(duration);
+        events.push_back({"solve", 1, timestamp, duration});
+        timestamp += duration;
+    }
+
+    std::vector<double> sorted = durations;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double duration : durations) {
+        total += duration;
+    }
+    std::printf("nodes: %zu, mode: %d, constraint: %gx%g\n", capture.nodes.size(), capture.layoutMode, capture.width, capture.height);
+    std::printf("solve (us): min %.1f, median %.1f, mean %.1f, max %.1f over %d iterations\n",
+                sorted.front(), sorted[sorted.size() / 2], total / durations.size(), sorted.back(), iterations);
+    std::printf("max frame difference with the capture: %g\n", difference);
+    if (missedMeasurementCount > 0) {
+        std::printf("measure calls per solve with constraints missing from the capture: %zu\n", missedMeasurementCount / iterations);
+    }
+
+    int status = 0;
+    if (!tracePath.empty()) {
+        traceSubtree(capture, 0, config, timestamp, sorted[sorted.size() / 2], &events);
+        if (!writeTrace(tracePath, events)) {
+            std::cerr << tracePath << ": cannot write trace" << std::endl;
+            status = 1;
+        }
+    }
+
+    YGConfigFree(config);
+    return status;
+}
@@ -0,0 +1,163 @@
+//
+//  FlexStaticCheck.cpp
+//  FlexLayout-OC
+//
+//  Checks the compile-time solver of `GMFlexStaticLayout.h`: the static_asserts below fail the build when a frame
+//  table differs from the frames expected from Yoga, and the program lays out the same trees with Yoga to compare
+//  every frame.
+//
+//  Build, against the Yoga version used by the app:
+//      c++ -std=c++14 -O2 -I<yoga> -I../../Sources FlexStaticCheck.cpp <yoga>/yoga/*.cpp -o flex-static-check
+//
+//  Usage:
+//      flex-static-check
+//
+
+#include "GMFlexStaticLayout.h"
+
+#include <cstdio>
+
+using gmflex::StaticFrame;
+using gmflex::StaticNode;
+
+namespace {
+
+constexpr bool frameEquals(const StaticFrame &frame, float left, float top, float width, float height)
+{
+    return frame.left == left && frame.top == top && frame.width == width && frame.height == height;
+}
+
+// A cell: a fixed size icon and a growing title.
+constexpr StaticNode cellNodes[] = {
+    StaticNode().direction(GMFlexDirectionRow).padding(12).alignItems(GMFlexAlignItemsCenter).items(2),
+        StaticNode().size(40, 40),
+        StaticNode().grow(1).height(20).marginLeft(8),
+};
+constexpr auto cellFrames = gmflex::solve(cellNodes, 375, 64, 3);
+static_assert(frameEquals(cellFrames[0], 0, 0, 375, 64), "cell");
+static_assert(frameEquals(cellFrames[1], 12, 12, 40, 40), "cell icon");
+static_assert(frameEquals(cellFrames[2], 60, 22, 303, 20), "cell title");
+
+// Stretched rows spread in a column.
+constexpr StaticNode listNodes[] = {
+    StaticNode().padding(10).justifyContent(GMFlexJustifyContentSpaceBetween).items(3),
+        StaticNode().height(30),
+        StaticNode().height(30),
+        StaticNode().height(30),
+};
+constexpr auto listFrames = gmflex::solve(listNodes, 100, 200, 2);
+static_assert(frameEquals(listFrames[1], 10, 10, 80, 30), "list first row");
+static_assert(frameEquals(listFrames[2], 10, 85, 80, 30), "list second row");
+static_assert(frameEquals(listFrames[3], 10, 160, 80, 30), "list third row");
+
+// Shrunk items in a reversed row, rounded to the pixel grid.
+constexpr StaticNode reversedNodes[] = {
+    StaticNode().direction(GMFlexDirectionRowReverse).items(2),
+        StaticNode().width(80).shrink(1),
+        StaticNode().width(40).shrink(1),
+};
+constexpr auto reversedFrames = gmflex::solve(reversedNodes, 100, 50, 2);
+static_assert(frameEquals(reversedFrames[1], 33.5f, 0, 66.5f, 50), "reversed first item");
+static_assert(frameEquals(reversedFrames[2], 0, 0, 33.5f, 50), "reversed second item");
+
+// Items sized by their content.
+constexpr StaticNode contentNodes[] = {
+    StaticNode().alignItems(GMFlexAlignItemsStart).items(2),
+        StaticNode().direction(GMFlexDirectionRow).padding(4).items(2),
+            StaticNode().size(20, 10),
+            StaticNode().size(30, 16).marginLeft(2),
+        StaticNode().size(100, 50).alignSelf(GMFlexAlignSelfCenter),
+};
+constexpr auto contentFrames = gmflex::solve(contentNodes, 320, 480, 2);
+static_assert(frameEquals(contentFrames[1], 0, 0, 60, 24), "content row");
+static_assert(frameEquals(contentFrames[2], 4, 4, 20, 10), "content first item");
+static_assert(frameEquals(contentFrames[3], 26, 4, 30, 16), "content second item");
+static_assert(frameEquals(contentFrames[4], 110, 24, 100, 50), "content centered item");
+
+// A root with margins: its frame is offset by them, and its size is the container's without them.
+constexpr StaticNode marginNodes[] = {
+    StaticNode().marginLeft(10).marginTop(5.5f).marginBottom(2).padding(4).items(1),
+        StaticNode().height(20).marginRight(3),
+};
+constexpr auto marginFrames = gmflex::solve(marginNodes, 100, 60, 2);
+static_assert(frameEquals(marginFrames[0], 10, 5.5f, 90, 52.5f), "margin root");
+static_assert(frameEquals(marginFrames[1], 4, 4, 79, 20), "margin item");
+
+const YGEdge edges[] = {YGEdgeLeft, YGEdgeTop, YGEdgeRight, YGEdgeBottom};
+
+/// Builds the Yoga node of `nodes[index]` and its subtree, returns the index following the subtree.
+size_t buildYogaNode(const StaticNode *nodes, size_t index, YGConfigRef config, YGNodeRef *yogaNodes)
+{
+    const gmflex::StaticStyle &style = nodes[index].style;
+    YGNodeRef node = YGNodeNewWithConfig(config);
+    YGNodeStyleSetFlexDirection(node, static_cast<YGFlexDirection>(style.direction));
+    YGNodeStyleSetJustifyContent(node, static_cast<YGJustify>(style.justifyContent));
+    YGNodeStyleSetAlignItems(node, static_cast<YGAlign>(style.alignItems));
+    YGNodeStyleSetAlignSelf(node, static_cast<YGAlign>(style.alignSelf));
+    YGNodeStyleSetFlexGrow(node, style.grow);
+    YGNodeStyleSetFlexShrink(node, style.shrink);
+    if (style.width >= 0) {
+        YGNodeStyleSetWidth(node, style.width);
+    }
+    if (style.height >= 0) {
+        YGNodeStyleSetHeight(node, style.height);
+    }
+    for (int edge = 0; edge < 4; edge++) {
+        YGNodeStyleSetMargin(node, edges[edge], style.margin[edge]);
+        YGNodeStyleSetPadding(node, edges[edge], style.padding[edge]);
+    }
+    yogaNodes[index] = node;
+
+    size_t child = index + 1;
+    for (size_t i = 0; i < style.itemCount; i++) {
+        const size_t childIndex = child;
+        child = buildYogaNode(nodes, childIndex, config, yogaNodes);
+        YGNodeInsertChild(node, yogaNodes[childIndex], static_cast<uint32_t>(i));
+    }
+    return child;
+}
+
+/// Lays out `nodes` with Yoga and compares the frames to the table solved at compile time.
+template <size_t N>
+bool check(const char *name, const StaticNode (&nodes)[N], const gmflex::StaticFrameTable<N> &table,
+           float width, float height, float scale)
+{
+    YGConfigRef config = YGConfigNew();
+    YGConfigSetPointScaleFactor(config, scale);
+    YGConfigSetExperimentalFeatureEnabled(config, YGExperimentalFeatureWebFlexBasis, true); // Like YogaKit
+    YGNodeRef yogaNodes[N];
+    buildYogaNode(nodes, 0, config, yogaNodes);
+    YGNodeCalculateLayout(yogaNodes[0], width, height, YGDirectionLTR);
+
+    bool matches = true;
+    for (size_t i = 0; i < N; i++) {
+        const StaticFrame &frame = table[i];
+        const float left = YGNodeLayoutGetLeft(yogaNodes[i]);
+        const float top = YGNodeLayoutGetTop(yogaNodes[i]);
+        const float nodeWidth = YGNodeLayoutGetWidth(yogaNodes[i]);
+        const float nodeHeight = YGNodeLayoutGetHeight(yogaNodes[i]);
+        if (frame.left != left || frame.top != top || frame.width != nodeWidth || frame.height != nodeHeight) {
+            std::printf("%s: node %zu is {%g, %g, %g, %g}, Yoga lays it out at {%g, %g, %g, %g}\n", name, i,
+                        frame.left, frame.top, frame.width, frame.height, left, top, nodeWidth, nodeHeight);
+            matches = false;
+        }
+    }
+
+    YGNodeFreeRecursive(yogaNodes[0]);
+    YGConfigFree(config);
+    return matches;
+}
+
+} // namespace
+
+int main()
+{
+    bool matches = true;
+    matches &= check("cell", cellNodes, cellFrames, 375, 64, 3);
+    matches &= check("list", listNodes, listFrames, 100, 200, 2);
+    matches &= check("reversed", reversedNodes, reversedFrames, 100, 50, 2);
+    matches &= check("content", contentNodes, contentFrames, 320, 480, 2);
+    matches &= check("margin", marginNodes, marginFrames, 100, 60, 2);
+    std::printf(matches ? "All static layouts match Yoga.\n" : "Static layouts differ from Yoga.\n");
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+//
+//  FlexTeardownBenchmark.cpp
+//  FlexLayout-OC
+//
+//  Compares the two ways the Yoga tree of a screen goes away. Per object: each node is freed along with its view,
+//  children before their parent as UIKit deallocates them, while still attached, so that it removes itself from its
+//  parent's children list. Released: `-[GMFlex releaseTree]` first unlinks every container from all its children at
+//  once, then each node is freed on its own. The program checks that both free every node, then reports the heap
+//  allocations made to build the tree and the teardown times.
+//
+//  Build, against the Yoga version used by the app:
+//      c++ -std=c++11 -O2 -I<yoga> FlexTeardownBenchmark.cpp <yoga>/yoga/*.cpp -o flex-teardown-benchmark
+//
+//  Usage:
+//      flex-teardown-benchmark [--rows <count>] [--iterations <count>]
+//
+
+#include <yoga/Yoga.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace {
+
+size_t allocationCount = 0;
+size_t liveAllocationCount = 0;
+
+struct Screen {
+    YGNodeRef root = nullptr;
+    std::vector<YGNodeRef> nodes; // Depth-first, parents before their children.
+    size_t allocationCount = 0; // Heap allocations made to build the tree.
+};
+
+YGNodeRef newNode(Screen *screen, YGConfigRef config, YGNodeRef parent)
+{
+    YGNodeRef node = YGNodeNewWithConfig(config);
+    if (parent != nullptr) {
+        YGNodeInsertChild(parent, node, YGNodeGetChildCount(parent));
+    }
+    screen->nodes.push_back(node);
+    return node;
+}
+
+// A feed screen: a wide column of rows made of an avatar, a title and a subtitle stacked, and a trailing badge.
+Screen buildScreen(YGConfigRef config, size_t rowCount)
+{
+    Screen screen;
+    screen.nodes.reserve(1 + 6 * rowCount);
+    const size_t initialCount = allocationCount;
+    screen.root = newNode(&screen, config, nullptr);
+    YGNodeStyleSetPadding(screen.root, YGEdgeAll, 16);
+    for (size_t i = 0; i < rowCount; i++) {
+        YGNodeRef row = newNode(&screen, config, screen.root);
+        YGNodeStyleSetFlexDirection(row, YGFlexDirectionRow);
+        YGNodeStyleSetAlignItems(row, YGAlignCenter);
+        YGNodeStyleSetMargin(row, YGEdgeTop, 8);
+
+        YGNodeRef avatar = newNode(&screen, config, row);
+        YGNodeStyleSetWidth(avatar, 40);
+        YGNodeStyleSetHeight(avatar, 40);
+
+        YGNodeRef texts = newNode(&screen, config, row);
+        YGNodeStyleSetFlexGrow(texts, 1);
+        YGNodeStyleSetMargin(texts, YGEdgeLeft, 12);
+        for (int line = 0; line < 2; line++) {
+            YGNodeRef text = newNode(&screen, config, texts);
+            YGNodeStyleSetHeight(text, 17);
+        }
+
+        YGNodeRef badge = newNode(&screen, config, row);
+        YGNodeStyleSetWidth(badge, 24);
+        YGNodeStyleSetHeight(badge, 24);
+    }
+    // The nodes vector was reserved before counting started.
+    screen.allocationCount = allocationCount - initialCount;
+    YGNodeCalculateLayout(screen.root, 375, YGUndefined, YGDirectionLTR);
+    return screen;
+}
+
+// Frees a node and its subtree the way views deallocate: the children first, each one still attached.
+void freeLikeViews(YGNodeRef node)
+{
+    std::vector<YGNodeRef> children;
+    for (uint32_t i = 0; i < YGNodeGetChildCount(node); i++) {
+        children.push_back(YGNodeGetChild(node, i));
+    }
+    for (YGNodeRef child : children) {
+        freeLikeViews(child);
+    }
+    YGNodeFree(node);
+}
+
+// Frees the tree the way it goes away after `-[GMFlex releaseTree]`.
+void freeReleased(const Screen &screen)
+{
+    for (YGNodeRef node : screen.nodes) {
+        YGNodeRemoveAllChildren(node);
+    }
+    for (auto it = screen.nodes.rbegin(); it != screen.nodes.rend(); ++it) {
+        YGNodeFree(*it);
+    }
+}
+
+// Median teardown time of a freshly built screen.
+double medianTeardownTime(YGConfigRef config, size_t rowCount, bool isReleased, int iterations)
+{
+    std::vector<double> durations;
+    for (int i = 0; i < iterations; i++) {
+        Screen screen = buildScreen(config, rowCount);
+        const auto start = std::chrono::steady_clock::now();
+        if (isReleased) {
+            freeReleased(screen);
+        } else {
+            freeLikeViews(screen.root);
+        }
+        durations.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(durations.begin(), durations.end());
+    return durations[durations.size() / 2];
+}
+
+} // namespace
+
+void *operator new(size_t size)
+{
+    void *memory = std::malloc(size == 0 ? 1 : size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    allocationCount++;
+    liveAllocationCount++;
+    return memory;
+}
+
+void operator delete(void *memory) noexcept
+{
+    if (memory != nullptr) {
+        liveAllocationCount--;
+        std::free(memory);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rowCount = 500;
+    int iterations = 50;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            rowCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--rows <count>] [--iterations <count>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    YGConfigRef config = YGConfigNew();
+    YGConfigSetPointScaleFactor(config, 3);
+    YGConfigSetExperimentalFeatureEnabled(config, YGExperimentalFeatureWebFlexBasis, true); // Like YogaKit
+
+    // Both paths must free every node and vector they allocated.
+    bool isLeaking = false;
+    for (int isReleased = 0; isReleased < 2; isReleased++) {
+        const size_t initialCount = liveAllocationCount;
+        {
+            Screen screen = buildScreen(config, rowCount);
+            isReleased ? freeReleased(screen) : freeLikeViews(screen.root);
+        }
+        isLeaking = isLeaking || liveAllocationCount != initialCount;
+    }
+
+    Screen screen = buildScreen(config, rowCount);
+    const size_t nodeCount = screen.nodes.size();
+    const size_t buildAllocationCount = screen.allocationCount;
+    freeReleased(screen);
+
+    const double perObjectTime = medianTeardownTime(config, rowCount, false, iterations);
+    const double releasedTime = medianTeardownTime(config, rowCount, true, iterations);
+    YGConfigFree(config);
+
+    std::printf("rows: %zu, iterations: %d\n", rowCount, iterations);
+    std::printf("build: %zu nodes, %zu heap allocations (%.1f per node)\n", nodeCount, buildAllocationCount,
+                static_cast<double>(buildAllocationCount) / nodeCount);
+    std::printf("In the app each node also has a GMFlex and a YGLayout, two more allocations per view.\n");
+    std::printf("per object: median teardown %.1f us\n", perObjectTime);
+    std::printf("released:   median teardown %.1f us\n", releasedTime);
+    std::printf("teardown time: -%.0f%%\n", 100.0 * (1.0 - releasedTime / perObjectTime));
+    if (isLeaking) {
+        std::printf("A teardown path leaks allocations.\n");
+        return 1;
+    }
+    std::printf("Both paths free every allocation.\n");
+    return 0;
+}
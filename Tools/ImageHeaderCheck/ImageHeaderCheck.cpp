@@ -0,0 +1,287 @@
+//
+//  ImageHeaderCheck.cpp
+//  FlexLayout-OC
+//
+//  Checks the image header parser of `GMImageHeader.h` on real image files and on crafted headers, then measures its
+//  throughput. Every image is also parsed one byte at a time, the way `aspectRatioOfImageFile` reads files by chunks:
+//  each prefix must ask for more data until the size is found, never fail.
+//
+//  Build:
+//      cc -std=c99 -O2 -c ../../Sources/Impl/GMImageHeader.c
+//      c++ -std=c++11 -O2 -I../../Sources/Impl ImageHeaderCheck.cpp GMImageHeader.o -o image-header-check
+//
+//  Usage:
+//      image-header-check [--fixtures <directory>] [--iterations <count>]
+//
+//  The fixtures directory defaults to Fixtures, next to this file.
+//
+
+#include "GMImageHeader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Expectation {
+    const char *name;
+    GMImageHeaderFormat format;
+    uint32_t width;
+    uint32_t height;
+};
+
+// Every fixture is a 123x45 image.
+const Expectation kFixtures[] = {
+    {"image.png", GMImageHeaderFormatPNG, 123, 45},
+    {"crushed.png", GMImageHeaderFormatPNG, 123, 45}, // CgBI chunk before IHDR, like app bundle PNGs
+    {"baseline.jpg", GMImageHeaderFormatJPEG, 123, 45},
+    {"progressive.jpg", GMImageHeaderFormatJPEG, 123, 45},
+    {"exif-rotated.jpg", GMImageHeaderFormatJPEG, 45, 123}, // Orientation 6, big-endian Exif
+    {"image.gif", GMImageHeaderFormatGIF, 123, 45},
+    {"lossy.webp", GMImageHeaderFormatWebP, 123, 45},
+    {"lossless.webp", GMImageHeaderFormatWebP, 123, 45},
+    {"extended.webp", GMImageHeaderFormatWebP, 123, 45},
+};
+
+struct Image {
+    std::string name;
+    std::vector<uint8_t> bytes;
+    Expectation expectation;
+};
+
+const char *statusName(GMImageHeaderStatus status)
+{
+    switch (status) {
+        case GMImageHeaderStatusOK:
+            return "OK";
+        case GMImageHeaderStatusNeedMoreData:
+            return "need more data";
+        case GMImageHeaderStatusInvalid:
+            return "invalid";
+    }
+    return "unknown";
+}
+
+void appendBE16(std::vector<uint8_t> *bytes, uint32_t value)
+{
+    bytes->push_back(static_cast<uint8_t>(value >> 8));
+    bytes->push_back(static_cast<uint8_t>(value));
+}
+
+// A JPEG whose frame header follows a little-endian Exif segment holding an orientation tag, then `paddingLength`
+// bytes of segments, like the thumbnails and color profiles of camera files.
+std::vector<uint8_t> makeJPEG(uint32_t width, uint32_t height, uint16_t orientation, size_t paddingLength)
+{
+    std::vector<uint8_t> bytes = {0xff, 0xd8};
+
+    // APP1: "Exif\0\0", then a TIFF header and an IFD0 holding the orientation only.
+    const uint8_t exif[] = {
+        'E', 'x', 'i', 'f', 0, 0,
+        'I', 'I', 0x2a, 0, 8, 0, 0, 0,
+        1, 0,
+        0x12, 0x01, 3, 0, 1, 0, 0, 0, static_cast<uint8_t>(orientation), static_cast<uint8_t>(orientation >> 8), 0, 0,
+        0, 0, 0, 0,
+    };
+    bytes.push_back(0xff);
+    bytes.push_back(0xe1);
+    appendBE16(&bytes, sizeof(exif) + 2);
+    bytes.insert(bytes.end(), std::begin(exif), std::end(exif));
+
+    // APP2 segments, 64 KB at most each.
+    while (paddingLength > 0) {
+        const size_t length = std::min<size_t>(paddingLength, 0xfff0);
+        bytes.push_back(0xff);
+        bytes.push_back(0xe2);
+        appendBE16(&bytes, static_cast<uint32_t>(length + 2));
+        bytes.insert(bytes.end(), length, 0x5a);
+        paddingLength -= length;
+    }
+
+    // SOF0: precision, height, width, one component.
+    const uint8_t frame[] = {0xff, 0xc0, 0, 11, 8, static_cast<uint8_t>(height >> 8), static_cast<uint8_t>(height),
+                             static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(width), 1, 1, 0x11, 0};
+    bytes.insert(bytes.end(), std::begin(frame), std::end(frame));
+    return bytes;
+}
+
+bool loadFixtures(const std::string &directory, std::vector<Image> *images)
+{
+    for (const Expectation &expectation : kFixtures) {
+        const std::string path = directory + "/" + expectation.name;
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "Cannot read %s\n", path.c_str());
+            return false;
+        }
+        Image image = {expectation.name, {}, expectation};
+        image.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        images->push_back(image);
+    }
+
+    images->push_back({"rotated 270 jpeg", makeJPEG(640, 480, 8, 0), {nullptr, GMImageHeaderFormatJPEG, 480, 640}});
+    images->push_back({"mirrored jpeg", makeJPEG(640, 480, 2, 0), {nullptr, GMImageHeaderFormatJPEG, 640, 480}});
+    images->push_back({"jpeg after 200 KB of metadata", makeJPEG(4032, 3024, 6, 200 * 1024),
+                       {nullptr, GMImageHeaderFormatJPEG, 3024, 4032}});
+    return true;
+}
+
+// Parses the whole image, then every prefix of it.
+bool checkImage(const Image &image)
+{
+    const Expectation &expected = image.expectation;
+    GMImageHeaderInfo info;
+    GMImageHeaderStatus status = GMImageHeaderParse(image.bytes.data(), image.bytes.size(), &info);
+    if (status != GMImageHeaderStatusOK) {
+        std::printf("%s: %s\n", image.name.c_str(), statusName(status));
+        return false;
+    }
+    if (info.format != expected.format || info.width != expected.width || info.height != expected.height) {
+        std::printf("%s: format %d, %ux%u, expected format %d, %ux%u\n", image.name.c_str(), info.format, info.width,
+                    info.height, expected.format, expected.width, expected.height);
+        return false;
+    }
+
+    bool hasFoundSize = false;
+    for (size_t length = 0; length <= image.bytes.size() && !hasFoundSize; length++) {
+        GMImageHeaderInfo prefixInfo;
+        status = GMImageHeaderParse(image.bytes.data(), length, &prefixInfo);
+        if (status == GMImageHeaderStatusOK) {
+            hasFoundSize = true;
+            if (prefixInfo.width != info.width || prefixInfo.height != info.height) {
+                std::printf("%s: the %zu bytes prefix gives %ux%u\n", image.name.c_str(), length, prefixInfo.width,
+                            prefixInfo.height);
+                return false;
+            }
+        } else if (status != GMImageHeaderStatusNeedMoreData) {
+            std::printf("%s: the %zu bytes prefix is %s\n", image.name.c_str(), length, statusName(status));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Headers that must be rejected, made from valid images.
+bool checkInvalidHeaders(const std::vector<Image> &images)
+{
+    struct Corruption {
+        const char *name;
+        const char *image;
+        size_t offset;
+        uint8_t value;
+    };
+    const Corruption corruptions[] = {
+        {"PNG without IHDR first", "image.png", 15, 'X'},
+        {"PNG of zero width", "image.png", 19, 0},
+        {"crushed PNG without IHDR after CgBI", "crushed.png", 31, 'X'},
+        {"crushed PNG of zero width", "crushed.png", 35, 0},
+        {"GIF of an unknown version", "image.gif", 4, '8'},
+        {"JPEG marker without its 0xff prefix", "baseline.jpg", 2, 0x00},
+        {"JPEG segment length below 2", "baseline.jpg", 5, 1},
+        {"lossy WebP without start code", "lossy.webp", 23, 0},
+        {"lossless WebP without signature", "lossless.webp", 20, 0},
+        {"WebP of an unknown chunk", "extended.webp", 15, 'Y'},
+        {"RIFF file that isn't a WebP", "lossy.webp", 8, 'A'},
+    };
+
+    bool isPassing = true;
+    for (const Corruption &corruption : corruptions) {
+        const auto image = std::find_if(images.begin(), images.end(), [&](const Image &candidate) {
+            return candidate.name == corruption.image;
+        });
+        std::vector<uint8_t> bytes = image->bytes;
+        bytes[corruption.offset] = corruption.value;
+        GMImageHeaderInfo info;
+        const GMImageHeaderStatus status = GMImageHeaderParse(bytes.data(), bytes.size(), &info);
+        if (status != GMImageHeaderStatusInvalid) {
+            std::printf("%s: %s\n", corruption.name, statusName(status));
+            isPassing = false;
+        }
+    }
+
+    const uint8_t garbage[] = "Not an image at all";
+    const uint8_t startOfScan[] = {0xff, 0xd8, 0xff, 0xda, 0, 2};
+    GMImageHeaderInfo info;
+    if (GMImageHeaderParse(garbage, sizeof(garbage), &info) != GMImageHeaderStatusInvalid ||
+        GMImageHeaderParse(startOfScan, sizeof(startOfScan), &info) != GMImageHeaderStatusInvalid ||
+        GMImageHeaderParse(nullptr, 0, &info) != GMImageHeaderStatusInvalid) {
+        std::printf("Garbage, a JPEG scan without frame header or no bytes at all are accepted\n");
+        isPassing = false;
+    }
+    return isPassing;
+}
+
+// Parses every image repeatedly and reports the parsed headers per second, with the length of each header: the
+// bytes up to the frame size, which the parser reaches by skipping segments and chunks rather than scanning them.
+void benchmark(const std::vector<Image> &images, int iterations)
+{
+    std::printf("%-32s %14s %14s\n", "image", "header bytes", "headers/s");
+    for (const Image &image : images) {
+        GMImageHeaderInfo info;
+        size_t headerLength = 1;
+        while (GMImageHeaderParse(image.bytes.data(), headerLength, &info) == GMImageHeaderStatusNeedMoreData) {
+            headerLength++;
+        }
+
+        uint64_t checksum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            GMImageHeaderParse(image.bytes.data(), image.bytes.size(), &info);
+            checksum += info.width;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (checksum != static_cast<uint64_t>(iterations) * image.expectation.width) {
+            std::printf("%s: inconsistent results\n", image.name.c_str());
+        }
+        std::printf("%-32s %14zu %14.0f\n", image.name.c_str(), headerLength, iterations / seconds);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::string directory = __FILE__;
+    const size_t separator = directory.find_last_of('/');
+    directory = (separator == std::string::npos ? std::string(".") : directory.substr(0, separator)) + "/Fixtures";
+    int iterations = 1000000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--fixtures") == 0 && i + 1 < argc) {
+            directory = argv[++i];
+        } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: %s [--fixtures <directory>] [--iterations <count>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Image> images;
+    if (!loadFixtures(directory, &images)) {
+        return 2;
+    }
+
+    size_t failureCount = 0;
+    for (const Image &image : images) {
+        if (!checkImage(image)) {
+            failureCount++;
+        }
+    }
+    if (!checkInvalidHeaders(images)) {
+        failureCount++;
+    }
+    if (failureCount > 0) {
+        std::printf("%zu checks failed.\n", failureCount);
+        return 1;
+    }
+    std::printf("All %zu images and the invalid headers are parsed as expected.\n", images.size());
+
+    benchmark(images, iterations);
+    return 0;
+}